@@ -0,0 +1,254 @@
+#include "app.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace cgx::term::apps {
+
+namespace ns_alloc {
+static std::atomic<bool>             is_armed{false};
+static std::atomic<bool>             is_trap{false};
+static std::atomic<size_t>           count{0};
+static std::atomic<size_t>           violation_count{0};
+static std::array<site_t, max_sites> site_list{};
+
+static void note(size_t size, const void* caller) {
+    count.fetch_add(1, std::memory_order_relaxed);
+    if (!is_armed.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const auto idx = violation_count.fetch_add(1, std::memory_order_relaxed);
+    if (idx < site_list.size()) {
+        site_list[idx] = {caller, size};
+    }
+    if (is_trap.load(std::memory_order_relaxed)) {
+        // stop in the debugger with the offending stack intact
+        std::abort();
+    }
+}
+
+static void* allocate(size_t size, const void* caller) {
+    note(size, caller);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+// for over-aligned types; aligned_alloc wants a multiple of the alignment
+static void* allocate(size_t size, size_t align, const void* caller) {
+    note(size, caller);
+    if (align < sizeof(void*)) {
+        align = sizeof(void*);
+    }
+    const size_t rounded = (size + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded == 0 ? align : rounded);
+}
+
+void arm(bool trap) {
+    site_list.fill({});
+    violation_count = 0;
+    is_trap         = trap;
+    is_armed        = true;
+}
+
+void disarm() {
+    is_armed = false;
+}
+
+bool armed() {
+    return is_armed;
+}
+
+size_t violations() {
+    return violation_count;
+}
+
+size_t allocations() {
+    return count;
+}
+
+const std::array<site_t, max_sites>& sites() {
+    return site_list;
+}
+
+struct args_t {
+    bool arm{false};
+    bool disarm{false};
+    bool trap{false};
+};
+
+inline constexpr auto schema = arg::schema<args_t>(
+    "alloc",
+    arg::opt('a', "arm: report any allocation from now on", &args_t::arm),
+    arg::opt('d', "disarm", &args_t::disarm),
+    arg::opt('t', "abort on the first violation", &args_t::trap)
+);
+}  // namespace ns_alloc
+
+cmd_t alloc = {
+    "alloc",
+    "audit heap allocations in steady state",
+    nullptr,                            // init
+    [](auto& term, const auto* args) {  // run
+        ns_alloc::args_t a{};
+        arg::line_t      line;
+        switch (ns_alloc::schema.parse(args, a, line)) {
+            case arg::status::ok:
+                break;
+            case arg::status::help:
+                term.print(arg::help<ns_alloc::schema>.data());
+                return cgx::term::cmd_t::ret_code::ok;
+            case arg::status::error:
+                term.print(arg::help<ns_alloc::schema>.data());
+                return cgx::term::cmd_t::ret_code::error;
+        }
+
+        if (a.disarm) {
+            ns_alloc::disarm();
+        }
+
+        const auto violations = ns_alloc::violations();
+        term.printf(
+            "%s, %zu allocations total, %zu while armed\n",
+            ns_alloc::armed() ? "armed" : "disarmed", ns_alloc::allocations(),
+            violations
+        );
+        const auto& sites = ns_alloc::sites();
+        for (size_t i = 0; i < violations && i < sites.size(); i++) {
+            term.printf(
+                "  %2zu: %6zu B from %p\n", i, sites[i].size, sites[i].caller
+            );
+        }
+        if (violations > 0) {
+            term.print("  resolve with: addr2line -f -C -e <elf> <address>\n");
+        }
+
+        // arm last so the report itself is not counted
+        if (a.arm) {
+            ns_alloc::arm(a.trap);
+            term.print("armed\n");
+        }
+        return violations > 0 ? cgx::term::cmd_t::ret_code::error
+                               : cgx::term::cmd_t::ret_code::ok;
+    },
+    nullptr,  // exit
+};
+
+}  // namespace cgx::term::apps
+
+void* operator new(std::size_t size) {
+    void* p = cgx::term::apps::ns_alloc::allocate(
+        size, __builtin_return_address(0)
+    );
+    if (p == nullptr) {
+#if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    void* p = cgx::term::apps::ns_alloc::allocate(
+        size, __builtin_return_address(0)
+    );
+    if (p == nullptr) {
+#if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return cgx::term::apps::ns_alloc::allocate(
+        size, __builtin_return_address(0)
+    );
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return cgx::term::apps::ns_alloc::allocate(
+        size, __builtin_return_address(0)
+    );
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#if defined(__cpp_aligned_new)
+void* operator new(std::size_t size, std::align_val_t align) {
+    void* p = cgx::term::apps::ns_alloc::allocate(
+        size, static_cast<std::size_t>(align), __builtin_return_address(0)
+    );
+    if (p == nullptr) {
+#if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    void* p = cgx::term::apps::ns_alloc::allocate(
+        size, static_cast<std::size_t>(align), __builtin_return_address(0)
+    );
+    if (p == nullptr) {
+#if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+    return p;
+}
+
+void* operator new(
+    std::size_t size, std::align_val_t align, const std::nothrow_t&
+) noexcept {
+    return cgx::term::apps::ns_alloc::allocate(
+        size, static_cast<std::size_t>(align), __builtin_return_address(0)
+    );
+}
+
+void* operator new[](
+    std::size_t size, std::align_val_t align, const std::nothrow_t&
+) noexcept {
+    return cgx::term::apps::ns_alloc::allocate(
+        size, static_cast<std::size_t>(align), __builtin_return_address(0)
+    );
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+#endif
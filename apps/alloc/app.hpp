@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+#include <functional>
+
+#include "../../term.hpp"
+
+// Linking this app replaces the global operator new/delete with counting
+// versions, so it is meant for debug and simulator builds. While armed, every
+// allocation is a steady-state violation and its call site is recorded.
+namespace cgx::term::apps {
+namespace ns_alloc {
+static constexpr size_t max_sites = 8;
+
+struct site_t {
+    const void* caller;
+    size_t      size;
+};
+
+// start/stop treating allocations as violations. arm() clears the record.
+void arm(bool trap = false);
+void disarm();
+
+bool   armed();
+size_t violations();
+size_t allocations();  // since startup, armed or not
+
+// first violations, in order
+const std::array<site_t, max_sites>& sites();
+}  // namespace ns_alloc
+
+extern cmd_t alloc;
+}  // namespace cgx::term::apps
@@ -1,6 +1,6 @@
 #include "app.hpp"
 
-#include "../../../scheduler/scheduler.hpp"
+#include "../scheduler.hpp"
 
 namespace cgx::term::apps {
 
@@ -0,0 +1,122 @@
+#include "app.hpp"
+
+#include "../scheduler.hpp"
+
+namespace cgx::term::apps {
+
+namespace ns_jobs {
+struct args_t {
+    const char* id{nullptr};
+};
+
+inline constexpr auto fg_schema = arg::schema<args_t>(
+    "fg", arg::pos("%n", "job to bring back, the newest by default", &args_t::id)
+);
+inline constexpr auto kill_schema = arg::schema<args_t>(
+    "kill", arg::pos("%n", "job to stop", &args_t::id)
+);
+
+void use_scheduler(term_t& term, int64_t period_us) {
+    term.set_job_hook([&term, period_us](uint32_t token) {
+        std::array<char, 16> name{};
+        std::snprintf(name.data(), name.size(), "job%u", token);
+        cgx::sch::scheduler.add({
+            name.data(),
+            period_us,
+            [&term, token] { return term.wake_job(token); },
+        });
+    });
+}
+
+size_t parse_id(const char* s) {
+    if (s == nullptr) {
+        return 0;
+    }
+    if (*s == '%') {
+        s++;
+    }
+    size_t id = 0;
+    if (!parse_value(s, id)) {
+        return 0;
+    }
+    return id;
+}
+
+size_t newest(const term_t& term) {
+    const auto& jobs = term.jobs();
+    for (size_t i = jobs.size(); i > 0; i--) {
+        if (jobs[i - 1].state() != job_t::state_t::free) {
+            return i;
+        }
+    }
+    return 0;
+}
+}  // namespace ns_jobs
+
+cmd_t jobs = {
+    "jobs",
+    "list background jobs, started with \"cmd &\"",
+    nullptr,                       // init
+    [](auto& term, const auto*) {  // run
+        const auto& jobs = term.jobs();
+        for (size_t i = 0; i < jobs.size(); i++) {
+            const auto& job = jobs[i];
+            if (job.state() == job_t::state_t::free) {
+                continue;
+            }
+            term.printf(
+                "[%zu] %-8s %-8s %-24s %zu B\n", i + 1,
+                job.state() == job_t::state_t::running ? "running" : "done",
+                term.commands()[job.cmd()].name(), job.args(),
+                job.output_size() + job.dropped()
+            );
+        }
+        return cgx::term::cmd_t::ret_code::ok;
+    },
+    nullptr,  // exit
+};
+
+cmd_t fg = {
+    "fg",
+    "show a job's output and bring it to the foreground",
+    nullptr,                            // init
+    [](auto& term, const auto* args) {  // run
+        ns_jobs::args_t a{};
+        arg::line_t     line;
+        if (ns_jobs::fg_schema.parse(args, a, line) != arg::status::ok) {
+            term.print(arg::help<ns_jobs::fg_schema>.data());
+            return cgx::term::cmd_t::ret_code::error;
+        }
+        const auto id =
+            a.id ? ns_jobs::parse_id(a.id) : ns_jobs::newest(term);
+        if (!term.foreground(id)) {
+            term.printf("fg: no such job\n");
+            return cgx::term::cmd_t::ret_code::error;
+        }
+        return cgx::term::cmd_t::ret_code::ok;
+    },
+    nullptr,  // exit
+};
+
+cmd_t kill = {
+    "kill",
+    "stop a background job: kill %n",
+    nullptr,                            // init
+    [](auto& term, const auto* args) {  // run
+        ns_jobs::args_t a{};
+        arg::line_t     line;
+        if (ns_jobs::kill_schema.parse(args, a, line) != arg::status::ok ||
+            a.id == nullptr) {
+            term.print(arg::help<ns_jobs::kill_schema>.data());
+            return cgx::term::cmd_t::ret_code::error;
+        }
+        if (!term.kill_job(ns_jobs::parse_id(a.id))) {
+            term.printf("kill: no such job: %s\n", a.id);
+            return cgx::term::cmd_t::ret_code::error;
+        }
+        return cgx::term::cmd_t::ret_code::ok;
+    },
+    nullptr,  // exit
+};
+
+}  // namespace cgx::term::apps
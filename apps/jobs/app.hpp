@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "../../term.hpp"
+
+namespace cgx::term::apps {
+namespace ns_jobs {
+// steps `term`'s background jobs from scheduler tasks, one per job, every
+// `period_us`
+void use_scheduler(term_t& term, int64_t period_us = 10'000);
+
+// "%n" or "n"; 0 if neither
+size_t parse_id(const char* s);
+}  // namespace ns_jobs
+
+extern cmd_t jobs;
+extern cmd_t fg;
+extern cmd_t kill;
+}  // namespace cgx::term::apps
@@ -0,0 +1,61 @@
+#include "app.hpp"
+
+namespace cgx::term::apps {
+
+namespace ns_mem {
+// footprint budgets: raise them deliberately when a change needs more RAM.
+// The hot-path trace ring only counts when it is compiled in.
+static constexpr size_t term_budget =
+    11 * 1024 + 512 + (trace_t::enabled ? sizeof(trace_t) : 0);
+static constexpr size_t cmd_budget  = 192;
+
+static_assert(
+    term_t::static_memory().term <= term_budget,
+    "term_t grew past its RAM budget"
+);
+static_assert(sizeof(cmd_t) <= cmd_budget, "cmd_t grew past its RAM budget");
+}  // namespace ns_mem
+
+cmd_t mem = {
+    "mem",
+    "show the memory used by the terminal and its apps",
+    nullptr,                       // init
+    [](auto& term, const auto*) {  // run
+        const auto m     = term.memory();
+        size_t     total = m.term + m.cmds_heap;
+
+        term.printf("%-12s %8zu B\n", "term_t", m.term);
+        term.printf(
+            "  %-10s %8zu B  peak %zu B\n", "input", m.input, m.input_peak
+        );
+        term.printf("  %-10s %8zu B\n", "line", m.line);
+        term.printf("  %-10s %8zu B\n", "history", m.history);
+        term.printf("  %-10s %8zu B\n", "log", m.log);
+        term.printf("  %-10s %8zu B\n", "jobs", m.jobs);
+        term.printf(
+            "%-12s %8zu B  (%zu x %zu B, heap)\n", "commands", m.cmds_heap,
+            m.cmds, sizeof(cmd_t)
+        );
+
+        for (const auto* p : term.producers()) {
+            if (p == nullptr) {
+                continue;
+            }
+            term.printf(
+                "%-12s %8zu B  peak %u B\n", p->name(), p->capacity(),
+                p->stats().peak.load()
+            );
+        }
+
+        term.print("statics\n");
+        for (auto f = footprint_t::first(); f != nullptr; f = f->next()) {
+            term.printf("  %-10s %8zu B\n", f->name(), f->bytes());
+            total += f->bytes();
+        }
+        term.printf("%-12s %8zu B\n", "total", total);
+        return cgx::term::cmd_t::ret_code::ok;
+    },
+    nullptr,  // exit
+};
+
+}  // namespace cgx::term::apps
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <functional>
+
+#include "../../term.hpp"
+
+namespace cgx::term::apps {
+extern cmd_t mem;
+}  // namespace cgx::term::apps
@@ -2,54 +2,139 @@
 
 #include <cstring>
 
-#include "../../../scheduler/scheduler.hpp"
+#include "../scheduler.hpp"
 
 namespace cgx::term::apps {
 
+namespace ns_pkill {
+bool match(const char* pattern, const char* s) {
+    const char* star      = nullptr;
+    const char* backtrack = nullptr;
+    while (*s != '\0') {
+        if (*pattern == '*') {
+            star      = pattern++;
+            backtrack = s;
+            continue;
+        }
+        if (*pattern == '?' || *pattern == *s) {
+            pattern++;
+            s++;
+            continue;
+        }
+        if (star == nullptr) {
+            return false;
+        }
+        // let the last '*' swallow one more character
+        pattern = star + 1;
+        s       = ++backtrack;
+    }
+    while (*pattern == '*') {
+        pattern++;
+    }
+    return *pattern == '\0';
+}
+
+result_t kill(
+    const std::array<const char*, max_patterns>& patterns, bool all
+) {
+    result_t    ret{};
+    const auto& threads = cgx::sch::scheduler.threads();
+    for (const auto& thread : threads) {
+        if (!thread) {
+            continue;
+        }
+        thread->lock();
+        for (auto& task : *thread) {
+            if (!task) {
+                continue;
+            }
+            for (size_t i = 0; i < patterns.size(); i++) {
+                if (patterns[i] == nullptr) {
+                    break;
+                }
+                if (!all && ret.matched[i]) {
+                    continue;
+                }
+                if (!match(patterns[i], task.name().data())) {
+                    continue;
+                }
+                ret.matched[i] = true;
+                if (ret.count < ret.names.size()) {
+                    auto& name = ret.names[ret.count];
+                    std::strncpy(name.data(), task.name().data(), name.size());
+                    name[name.size() - 1] = '\0';
+                }
+                ret.count++;
+                task.kill();
+                break;
+            }
+        }
+        thread->unlock();
+    }
+    return ret;
+}
+
+struct args_t {
+    bool                                  all{false};
+    std::array<const char*, max_patterns> names{};
+};
+
+inline constexpr auto schema = arg::schema<args_t>(
+    "pkill",
+    arg::opt('a', "kill all matching processes", &args_t::all),
+    arg::pos("names", "process names or globs", &args_t::names)
+);
+}  // namespace ns_pkill
+
 cmd_t pkill = {
     "pkill",
-    "kill a process",
+    "kill processes by name or glob pattern",
     nullptr,                            // init
     [](auto& term, const auto* args) {  // run
-        param<bool> all{'a', "kill all processes with the same name", args};
-        param<void> name{"name of the process to kill", args};
-
-        auto is_help = param_help(
-            term, "pkill", args,
-            {
-                &all,
-                &name,
-            });
-        if (is_help) {
-            return cgx::term::cmd_t::ret_code::ok;
+        ns_pkill::args_t a{};
+        arg::line_t      line;
+        switch (ns_pkill::schema.parse(args, a, line)) {
+            case arg::status::ok:
+                break;
+            case arg::status::help:
+                term.print(arg::help<ns_pkill::schema>.data());
+                return cgx::term::cmd_t::ret_code::ok;
+            case arg::status::error:
+                term.print(arg::help<ns_pkill::schema>.data());
+                return cgx::term::cmd_t::ret_code::error;
         }
 
-        if (strlen(name.value()) == 0) {
+        const auto& patterns = a.names;
+        if (patterns[0] == nullptr) {
             term.printf("process name is required\n");
             return cgx::term::cmd_t::ret_code::error;
         }
 
-        if (all) {
-            bool ret = false;
-            while (cgx::sch::scheduler.pkill(name)) {
-                term.printf("%s killed\n", name.value());
-                ret = true;
+        const auto ret = ns_pkill::kill(patterns, a.all);
+
+        for (size_t i = 0; i < patterns.size(); i++) {
+            if (patterns[i] == nullptr) {
+                break;
             }
-            if (ret) {
-                return cgx::term::cmd_t::ret_code::ok;
-            }
-        } else {
-            if (cgx::sch::scheduler.pkill(name)) {
-                term.printf("%s killed\n", name.value());
-                return cgx::term::cmd_t::ret_code::ok;
+            if (!ret.matched[i]) {
+                term.printf("%s not found\n", patterns[i]);
             }
         }
+        if (ret.count == 0) {
+            return cgx::term::cmd_t::ret_code::error;
+        }
 
-        term.printf("%s not found\n", name.value());
-        return cgx::term::cmd_t::ret_code::error;
+        term.printf("killed %zu:", ret.count);
+        for (size_t i = 0; i < ret.count && i < ret.names.size(); i++) {
+            term.printf(" %s", ret.names[i].data());
+        }
+        if (ret.count > ret.names.size()) {
+            term.printf(" (+%zu more)", ret.count - ret.names.size());
+        }
+        term.print("\n");
+        return cgx::term::cmd_t::ret_code::ok;
     },
     nullptr,  // exit
 };
 
 }
-
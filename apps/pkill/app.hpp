@@ -1,9 +1,30 @@
 #pragma once
 
+#include <array>
 #include <functional>
 
 #include "../../term.hpp"
 
 namespace cgx::term::apps {
+namespace ns_pkill {
+static constexpr size_t max_patterns = 8;
+static constexpr size_t max_reported = 16;
+
+struct result_t {
+    size_t                                         count{0};
+    std::array<std::array<char, 16>, max_reported> names{};
+    std::array<bool, max_patterns>                 matched{};
+};
+
+// '*' matches any run of characters, '?' matches exactly one
+bool match(const char* pattern, const char* s);
+
+// kills every task matching any of the patterns in a single pass, locking
+// each thread once. If `all` is false, each pattern kills at most one task.
+result_t kill(
+    const std::array<const char*, max_patterns>& patterns, bool all
+);
+}  // namespace ns_pkill
+
 extern cmd_t pkill;
 }  // namespace cgx::term::apps
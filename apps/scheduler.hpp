@@ -0,0 +1,11 @@
+#pragma once
+
+// The apps are written against cgx::sch, which normally lives next to this
+// repo. Builds without it, or with CGX_TERM_SIM_SCHEDULER defined, use the
+// host stand-in in sim/.
+#if !defined(CGX_TERM_SIM_SCHEDULER) && \
+    __has_include("../../scheduler/scheduler.hpp")
+#include "../../scheduler/scheduler.hpp"
+#else
+#include "../sim/scheduler.hpp"
+#endif
@@ -1,24 +1,180 @@
 #include "app.hpp"
 
-#include "../../../scheduler/scheduler.hpp"
+#include <atomic>
+#include <chrono>
+
+#include "../scheduler.hpp"
+#include "record.hpp"
 
 namespace cgx::term::apps {
 
 namespace ns_top {
-void stats_screen(term_t& term) {
+struct args_t {
+    bool                          batch{false};
+    cgx::sch::scheduler_t::time_t period{1'000'000};
+    uint32_t                      samples{1u << 16};
+    const char*                   file{nullptr};
+};
+
+inline constexpr auto schema = arg::schema<args_t>(
+    "top",
+    arg::opt(
+        'b', "record samples to a file instead of drawing", &args_t::batch
+    ),
+    arg::opt('n', "refresh period (500ms, 2s...)", &args_t::period),
+    arg::opt('s', "rows kept in the recording", &args_t::samples),
+    arg::pos("file", "recording, top.rec by default", &args_t::file)
+);
+
+producer<8192>           out{"top"};
+static const footprint_t out_footprint{"top", sizeof(out)};
+
+static arg::status           status{arg::status::ok};
+static bool                  running{false};  // one top per process
+static record::writer_t      recorder{};
+static std::atomic<bool>     recording{false};
+static std::atomic<uint32_t> recording_id{0};  // tells recordings apart
+// held by a round in flight, and by exit while it closes the recording
+static std::atomic_flag recorder_busy = ATOMIC_FLAG_INIT;
+
+// stats_t reports max() and lowest() as min and max until its first sample
+template <typename S>
+void set_stats(record::sample_t& row, const S& stats) {
+    using time_t = cgx::sch::scheduler_t::time_t;
+    const auto min = stats.min();
+    const auto max = stats.max();
+    row.mean       = stats.mean();
+    row.min        = min == std::numeric_limits<time_t>::max() ? 0 : min;
+    row.max        = max == std::numeric_limits<time_t>::lowest() ? 0 : max;
+}
+
+// one round of rows: every thread's loop time, then its tasks. A round that
+// would fill the sample ring is cut short.
+void record_round() {
+    using namespace std::chrono;
+    recorder.begin(
+        duration_cast<microseconds>(system_clock::now().time_since_epoch())
+            .count()
+    );
     const auto& threads = cgx::sch::scheduler.threads();
+    for (uint8_t idx = 0; idx < threads.size(); ++idx) {
+        if (!threads[idx]) {
+            continue;
+        }
+        auto& thread = threads[idx];
 
-    static int32_t        last_lines = 0;
-    std::array<char, 128> buf;
+        record::sample_t row{};
+        row.kind   = record::kind_t::thread;
+        row.thread = idx;
+        row.tasks  = thread->size();
+        thread->lock();
+        set_stats(row, thread->watch().duration());
+        thread->unlock();
+        if (!recorder.add(row)) {
+            break;
+        }
+
+        bool full = false;
+        thread->lock();
+        for (const auto& task : *thread) {
+            if (!task) {
+                continue;
+            }
+            record::sample_t row{};
+            row.kind   = record::kind_t::task;
+            row.thread = idx;
+            row.status = static_cast<uint8_t>(task.status());
+            row.period = task.period();
+            row.actual = task.actual_period().mean();
+            std::strncpy(row.name, task.name().data(), sizeof(row.name) - 1);
+            set_stats(row, task.run_time());
+            if (!recorder.add(row)) {
+                full = true;
+                break;
+            }
+        }
+        thread->unlock();
+        if (full) {
+            break;
+        }
+    }
+    recorder.commit();
+}
+
+// a screen is one message per row, so a frame larger than the ring shows
+// the rows that fit instead of being dropped whole
+struct screen_t {
+    // kept free for the last line and the clean-up after it
+    static constexpr size_t tail_room = 256;
+
+    int32_t lines{0};
+    size_t  hidden{0};  // rows left out, the ring was full
+
+    // once a row is left out the rest are too, they need not be formatted
+    bool full() const {
+        return hidden > 0;
+    }
+    void skip() {
+        hidden++;
+    }
+
+    void row(const char* color, const char* text) {
+        // the escapes around the text and the message header
+        const size_t len = std::strlen(color) + std::strlen(text) + 16;
+        if (full() || out.available() < len + tail_room ||
+            !out.begin()) {
+            hidden++;
+            return;
+        }
+        out.print("\033[2K");
+        out.print(color);
+        out.print(text);
+        out.print("\033[0m");
+        if (out.commit()) {
+            lines++;
+        } else {
+            hidden++;
+        }
+    }
 
-    term.print("\033[2K");
-    term.print("\033[1m");
+    // clears what is left of the previous screen and homes the cursor
+    void end(int32_t last_lines) {
+        if (!out.begin()) {
+            return;
+        }
+        if (hidden > 0) {
+            out.printf("\033[2K\033[33m... %zu more rows\033[0m\n", hidden);
+            lines++;
+        }
+        for (int32_t i = lines; i < last_lines; ++i) {
+            // the cursor stays in place when there is no room to clear
+            if (out.available() < tail_room / 2) {
+                break;
+            }
+            out.print("\033[2K\n");
+        }
+        out.print("\033[H");
+        out.commit();
+    }
+};
 
-    term.printf("%93s\n", "TOP (q)uit (r)eset_stats (n)ow");
+void stats_screen() {
+    // another thread is already rendering a screen
+    static std::atomic_flag drawing = ATOMIC_FLAG_INIT;
+    if (drawing.test_and_set(std::memory_order_acquire)) {
+        return;
+    }
+    const auto& threads = cgx::sch::scheduler.threads();
+
+    static int32_t        last_lines = 0;
+    std::array<char, 128> buf;
+    screen_t              screen;
 
-    term.print("\033[0m");
+    std::snprintf(
+        buf.data(), buf.size(), "%93s\n", "TOP (q)uit (r)eset_stats (n)ow"
+    );
+    screen.row("\033[1m", buf.data());
 
-    int32_t lines = 0;
     for (uint8_t idx = 0; idx < threads.size(); ++idx) {
         if (!threads[idx]) {
             continue;
@@ -48,42 +204,39 @@ void stats_screen(term_t& term) {
                       idx, available_tasks, watch.duration().mean(), min, max);
         std::snprintf(buf.data() + std::strlen(buf.data()), buf.size(), "%*s\n",
                       93 - std::strlen(buf.data()), "");
-        term.print("\033[2K");
-        term.print("\033[30;42m");
-        term.print(buf.data());
-        term.print("\033[0m");
-        lines++;
+        screen.row("\033[30;42m", buf.data());
 
         std::snprintf(
             buf.data(), buf.size(), "   %10s %12s %12s %12s %12s %12s %12s\n",
             "task", "every", "actual", "next", "mean_us", "min_us", "max_us");
-        term.print("\033[2K");
-        term.print("\033[90m");
-        term.print(buf.data());
-        term.print("\033[0m");
-        lines++;
+        screen.row("\033[90m", buf.data());
 
         thread->lock();
         for (const auto& task : *thread) {
             if (!task) {
                 continue;
             }
-            char state[3] = "  ";
+            if (screen.full()) {
+                screen.skip();
+                continue;
+            }
+            char        state[3] = "  ";
+            const char* color    = "";
             switch (task.status()) {
                 case cgx::sch::task_t::status_t::running:
                     state[0] = 'O';
-                    term.print("\033[1;32m");
+                    color    = "\033[1;32m";
                     break;
                 case cgx::sch::task_t::status_t::stopped:
                     state[1] = 'S';
-                    term.print("\033[1;91m");
+                    color    = "\033[1;91m";
                     break;
                 case cgx::sch::task_t::status_t::paused:
                     state[1] = 'p';
                     break;
                 case cgx::sch::task_t::status_t::delayed:
                     state[0] = 'd';
-                    term.print("\033[31m");
+                    color    = "\033[31m";
                     break;
                 case cgx::sch::task_t::status_t::invalid:
                     state[1] = '-';
@@ -106,60 +259,148 @@ void stats_screen(term_t& term) {
                 "%2s [%8s] %12lld %12lld %12lld %12llu %12llu %12llu\n", state,
                 task.name().data(), task.period(), task.actual_period().mean(),
                 task.ticks_left(), run_time.mean(), min, max);
-            term.print("\033[2K");
-            term.print(buf.data());
-            term.print("\033[0m");
-            lines++;
+            screen.row(color, buf.data());
         }
         thread->unlock();
-        term.print("\033[2K");
-        term.print("\n");
-        lines++;
+        screen.row("", "\n");
     }
 
-    for (int32_t i = 0; i < last_lines - lines; ++i) {
-        term.print("\033[2K");
-        term.print("\n");
-    }
-    term.print("\033[H");
+    screen.end(last_lines);
+    last_lines = screen.lines;
+    drawing.clear(std::memory_order_release);
 }
 }  // namespace ns_top
 
 cmd_t top = {
     "top",
     "show current processes",
-    [](auto& term, const auto*) {  // init
+    [](auto& term, const auto* args) {  // init
+        // another session or job owns the statics below
+        if (ns_top::running) {
+            term.print("top: already running\n");
+            return false;
+        }
+        ns_top::args_t a{};
+        arg::line_t    line;
+        ns_top::recording = false;
+        ns_top::status    = ns_top::schema.parse(args, a, line);
+        if (ns_top::status == arg::status::ok && a.period <= 0) {
+            ns_top::status = arg::status::error;
+        }
+        if (ns_top::status != arg::status::ok) {
+            term.print(arg::help<ns_top::schema>.data());
+            return true;
+        }
+        const int64_t period = a.period;
+
+        if (a.batch) {
+            const char* file = a.file ? a.file : "top.rec";
+            // one index entry for every 8 rows leaves room for small rounds
+            const uint64_t rounds = a.samples / 8 ? a.samples / 8 : 1;
+            if (!ns_top::recorder.open(file, a.samples, rounds, period)) {
+                term.printf("top: cannot record to %s\n", file);
+                ns_top::status = arg::status::error;
+                return true;
+            }
+            ns_top::recording = true;
+            ns_top::running   = true;
+            term.printf(
+                "top: recording to %s every %lldus, (q)uit\n", file,
+                static_cast<long long>(period)
+            );
+            cgx::sch::scheduler.add({
+                "top",
+                period,
+                [id = ++ns_top::recording_id] {
+                    // exit is closing the file, the next run sees it closed
+                    if (ns_top::recorder_busy.test_and_set(
+                            std::memory_order_acquire
+                        )) {
+                        return true;
+                    }
+                    const bool keep =
+                        ns_top::recording && ns_top::recording_id == id;
+                    if (keep) {
+                        ns_top::record_round();
+                    }
+                    ns_top::recorder_busy.clear(std::memory_order_release);
+                    return keep;
+                },
+            });
+            return true;
+        }
+
         term.print("\033[2J");
         term.print("\033[H");
+        term.attach(ns_top::out);
+        ns_top::running = true;
         cgx::sch::scheduler.add({
             "top",
-            1000'000,
-            [&term] {
-                ns_top::stats_screen(term);
+            period,
+            [] {
+                ns_top::stats_screen();
                 return true;
             },
         });
         return true;
     },
-    [](auto& term, const auto* args) {  // run
+    [](auto&, const auto* args) {  // run
+        if (ns_top::status == arg::status::help) {
+            return cgx::term::cmd_t::ret_code::ok;
+        }
+        if (ns_top::status == arg::status::error) {
+            return cgx::term::cmd_t::ret_code::error;
+        }
+        // first call from the command line carries no arguments
+        if (args == nullptr) {
+            return cgx::term::cmd_t::ret_code::alive;
+        }
         if (strcmp(args, "q") == 0) {
             return cgx::term::cmd_t::ret_code::ok;
         }
+        // no screen while recording, its frames would wait in the producer
+        // for the next top to attach it
+        if (ns_top::recording) {
+            return cgx::term::cmd_t::ret_code::alive;
+        }
         if (strcmp(args, "r") == 0) {
             cgx::sch::scheduler.reset_stats();
-            ns_top::stats_screen(term);
+            ns_top::stats_screen();
             return cgx::term::cmd_t::ret_code::alive;
         }
         if (strcmp(args, "n") == 0) {
-            ns_top::stats_screen(term);
+            ns_top::stats_screen();
             return cgx::term::cmd_t::ret_code::alive;
         }
         return cgx::term::cmd_t::ret_code::alive;
     },
     [](auto& term, const auto*) {  // exit
+        if (ns_top::status != arg::status::ok) {
+            return true;
+        }
         cgx::sch::scheduler.pkill("top");
+        if (ns_top::recording) {
+            // pkill does not stop a round already running on a scheduler
+            // thread; let it finish before the file is unmapped
+            while (ns_top::recorder_busy.test_and_set(
+                std::memory_order_acquire
+            )) {
+            }
+            ns_top::recording = false;
+            const auto rounds = ns_top::recorder.rounds();
+            ns_top::recorder.close();
+            ns_top::recorder_busy.clear(std::memory_order_release);
+            ns_top::running = false;
+            term.printf(
+                "top: recorded %u rounds\n", static_cast<unsigned>(rounds)
+            );
+            return true;
+        }
+        term.flush();
+        term.detach(ns_top::out);
         term.print("\033[2J");
         term.print("\033[H");
+        ns_top::running = false;
         return true;
     },
 };
@@ -6,7 +6,10 @@
 
 namespace cgx::term::apps {
 namespace ns_top {
-void stats_screen(std::function<void(const char*)> print);
+// output of the screen, flushed by the terminal loop
+extern producer<8192> out;
+
+void stats_screen();
 }  // namespace ns_top
 
 extern cmd_t top;
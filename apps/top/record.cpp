@@ -0,0 +1,230 @@
+#include "record.hpp"
+
+#include <cstring>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CGX_TOP_RECORD 1
+#else
+#define CGX_TOP_RECORD 0
+#endif
+
+namespace cgx::term::apps::ns_top::record {
+
+#if CGX_TOP_RECORD
+
+bool writer_t::open(
+    const char* path,
+    uint64_t    sample_capacity,
+    uint64_t    index_capacity,
+    int64_t     period_us
+) {
+    close();
+    if (sample_capacity == 0 || index_capacity == 0) {
+        return false;
+    }
+    m_fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) {
+        return false;
+    }
+    m_size = file_size(sample_capacity, index_capacity);
+    struct stat st {};
+    const bool  resume = ::fstat(m_fd, &st) == 0 &&
+                        static_cast<size_t>(st.st_size) == m_size;
+    if (!resume && ::ftruncate(m_fd, m_size) != 0) {
+        close();
+        return false;
+    }
+    m_map = ::mmap(
+        nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0
+    );
+    if (m_map == MAP_FAILED) {
+        m_map = nullptr;
+        close();
+        return false;
+    }
+    auto* base = static_cast<char*>(m_map);
+    m_header   = reinterpret_cast<header_t*>(base);
+    m_index    = reinterpret_cast<index_t*>(base + index_offset);
+    m_samples =
+        reinterpret_cast<sample_t*>(base + sample_offset(index_capacity));
+
+    const bool same_format =
+        resume && std::memcmp(m_header->magic, magic, sizeof(magic)) == 0 &&
+        m_header->header_size == sizeof(header_t) &&
+        m_header->sample_size == sizeof(sample_t) &&
+        m_header->sample_capacity == sample_capacity &&
+        m_header->index_capacity == index_capacity;
+    if (!same_format) {
+        std::memset(m_header, 0, sizeof(header_t));
+        std::memcpy(m_header->magic, magic, sizeof(magic));
+        m_header->header_size     = sizeof(header_t);
+        m_header->sample_size     = sizeof(sample_t);
+        m_header->sample_capacity = sample_capacity;
+        m_header->index_capacity  = index_capacity;
+    }
+    m_header->period_us = period_us;
+    return true;
+}
+
+void writer_t::close() {
+    if (m_map != nullptr) {
+        ::msync(m_map, m_size, MS_ASYNC);
+        ::munmap(m_map, m_size);
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_fd      = -1;
+    m_map     = nullptr;
+    m_header  = nullptr;
+    m_index   = nullptr;
+    m_samples = nullptr;
+}
+
+void writer_t::begin(int64_t time_us) {
+    m_next = m_header->samples;
+    m_time = time_us;
+}
+
+bool writer_t::add(const sample_t& sample) {
+    // the ring would wrap onto the round's own first rows
+    if (m_next - m_header->samples >= m_header->sample_capacity) {
+        return false;
+    }
+    auto& row   = m_samples[m_next % m_header->sample_capacity];
+    row         = sample;
+    row.time_us = m_time;
+    row.round   = m_header->rounds;
+    m_next++;
+    return true;
+}
+
+void writer_t::commit() {
+    auto& entry   = m_index[m_header->rounds % m_header->index_capacity];
+    entry.time_us = m_time;
+    entry.sample  = m_header->samples;
+    // publish the rows before the counters that make them visible
+    __atomic_store_n(&m_header->samples, m_next, __ATOMIC_RELEASE);
+    __atomic_store_n(
+        &m_header->rounds, m_header->rounds + 1, __ATOMIC_RELEASE
+    );
+}
+
+bool reader_t::open(const char* path) {
+    close();
+    m_fd = ::open(path, O_RDONLY);
+    if (m_fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (::fstat(m_fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(header_t)) {
+        close();
+        return false;
+    }
+    m_size = st.st_size;
+    m_map  = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (m_map == MAP_FAILED) {
+        m_map = nullptr;
+        close();
+        return false;
+    }
+    const auto* base = static_cast<const char*>(m_map);
+    m_header         = reinterpret_cast<const header_t*>(base);
+    if (std::memcmp(m_header->magic, magic, sizeof(magic)) != 0 ||
+        m_header->header_size != sizeof(header_t) ||
+        m_header->sample_size != sizeof(sample_t) ||
+        m_header->sample_capacity == 0 || m_header->index_capacity == 0 ||
+        file_size(m_header->sample_capacity, m_header->index_capacity) !=
+            m_size) {
+        close();
+        return false;
+    }
+    m_index   = reinterpret_cast<const index_t*>(base + index_offset);
+    m_samples = reinterpret_cast<const sample_t*>(
+        base + sample_offset(m_header->index_capacity)
+    );
+    return true;
+}
+
+void reader_t::close() {
+    if (m_map != nullptr) {
+        ::munmap(const_cast<void*>(m_map), m_size);
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_fd     = -1;
+    m_map    = nullptr;
+    m_header = nullptr;
+}
+
+uint64_t reader_t::first_round() const {
+    const auto rounds = m_header->rounds;
+    const auto cap    = m_header->index_capacity;
+    auto       lo     = rounds > cap ? rounds - cap : 0;
+    // older rounds whose rows the sample ring has overwritten
+    const auto samples = m_header->samples;
+    const auto oldest  = samples > m_header->sample_capacity
+                             ? samples - m_header->sample_capacity
+                             : 0;
+    auto       hi      = rounds;
+    while (lo < hi) {
+        const auto mid = lo + (hi - lo) / 2;
+        if (entry(mid).sample < oldest) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+uint64_t reader_t::seek(int64_t time_us) const {
+    auto lo = first_round();
+    auto hi = end_round();
+    while (lo < hi) {
+        const auto mid = lo + (hi - lo) / 2;
+        if (entry(mid).time_us < time_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < end_round() ? lo : npos;
+}
+
+#else
+
+bool writer_t::open(const char*, uint64_t, uint64_t, int64_t) {
+    return false;
+}
+void writer_t::close() {
+}
+void writer_t::begin(int64_t) {
+}
+bool writer_t::add(const sample_t&) {
+    return false;
+}
+void writer_t::commit() {
+}
+
+bool reader_t::open(const char*) {
+    return false;
+}
+void reader_t::close() {
+}
+uint64_t reader_t::first_round() const {
+    return 0;
+}
+uint64_t reader_t::seek(int64_t) const {
+    return npos;
+}
+
+#endif
+
+}  // namespace cgx::term::apps::ns_top::record
@@ -0,0 +1,168 @@
+#pragma once
+
+// Binary recording of top's stats, written by `top -b` and read back by
+// top_replay. The file is a header, an index ring with one entry per
+// sampling round and a ring of fixed-size rows, one per thread and task:
+//
+//   [header_t][index_t x index_capacity][sample_t x sample_capacity]
+//
+// Rounds are found by time with a binary search over the index, so a reader
+// never has to scan the rows. Only available where <sys/mman.h> is.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cgx::term::apps::ns_top::record {
+
+inline constexpr char     magic[8] = {'C', 'G', 'X', 'T', 'O', 'P', 'R', '1'};
+inline constexpr uint64_t npos     = static_cast<uint64_t>(-1);
+
+struct header_t {
+    char     magic[8];
+    uint32_t header_size;
+    uint32_t sample_size;
+    uint64_t sample_capacity;  // rows in the sample ring
+    uint64_t index_capacity;   // rounds in the index ring
+    uint64_t samples;          // rows ever written, the next goes to
+                               // samples % sample_capacity
+    uint64_t rounds;           // rounds ever written
+    int64_t  period_us;        // sampling period
+    uint64_t reserved;
+};
+
+struct index_t {
+    int64_t  time_us;  // wall clock, microseconds since the epoch
+    uint64_t sample;   // first row of the round
+};
+
+enum class kind_t : uint8_t {
+    thread,
+    task,
+};
+
+struct sample_t {
+    int64_t  time_us;
+    uint64_t round;
+    kind_t   kind;
+    uint8_t  thread;
+    uint8_t  status;  // tasks: cgx::sch::task_t::status_t
+    uint8_t  reserved[5];
+    char     name[16];  // tasks only
+    int64_t  period;    // tasks: configured period
+    int64_t  actual;    // tasks: mean actual period
+    int64_t  mean;      // tasks: run time, threads: loop duration
+    int64_t  min;
+    int64_t  max;
+    uint64_t tasks;  // threads: tasks on the thread
+};
+
+static_assert(sizeof(header_t) == 64, "header_t is part of the file format");
+static_assert(sizeof(index_t) == 16, "index_t is part of the file format");
+static_assert(sizeof(sample_t) == 88, "sample_t is part of the file format");
+
+inline constexpr size_t index_offset = sizeof(header_t);
+
+inline constexpr size_t sample_offset(uint64_t index_capacity) {
+    return index_offset + index_capacity * sizeof(index_t);
+}
+
+inline constexpr size_t file_size(
+    uint64_t sample_capacity, uint64_t index_capacity
+) {
+    return sample_offset(index_capacity) + sample_capacity * sizeof(sample_t);
+}
+
+// Appends rounds to a recording, resuming one made with the same sizes
+class writer_t {
+   public:
+    ~writer_t() {
+        close();
+    }
+
+    bool open(
+        const char* path,
+        uint64_t    sample_capacity,
+        uint64_t    index_capacity,
+        int64_t     period_us
+    );
+    void close();
+    bool is_open() const {
+        return m_header != nullptr;
+    }
+
+    // a round is every row added between begin() and commit(). Rows are
+    // visible to readers once the round is committed. add() returns false,
+    // and keeps nothing, once the round fills the whole sample ring.
+    void begin(int64_t time_us);
+    bool add(const sample_t& sample);
+    void commit();
+
+    uint64_t rounds() const {
+        return m_header ? m_header->rounds : 0;
+    }
+    uint64_t samples() const {
+        return m_header ? m_header->samples : 0;
+    }
+
+   private:
+    int       m_fd{-1};
+    void*     m_map{nullptr};
+    size_t    m_size{0};
+    header_t* m_header{nullptr};
+    index_t*  m_index{nullptr};
+    sample_t* m_samples{nullptr};
+    uint64_t  m_next{0};  // row being written in the open round
+    int64_t   m_time{0};
+};
+
+// Read-only view of a recording
+class reader_t {
+   public:
+    ~reader_t() {
+        close();
+    }
+
+    bool open(const char* path);
+    void close();
+
+    const header_t& header() const {
+        return *m_header;
+    }
+
+    // rounds [first_round(), end_round()) are still whole in the file
+    uint64_t first_round() const;
+    uint64_t end_round() const {
+        return m_header->rounds;
+    }
+    int64_t round_time(uint64_t round) const {
+        return entry(round).time_us;
+    }
+
+    // first kept round taken at or after `time_us`, npos if none
+    uint64_t seek(int64_t time_us) const;
+
+    // calls f(const sample_t&) for each row of `round`
+    template <typename F>
+    void for_each(uint64_t round, F&& f) const {
+        const auto from = entry(round).sample;
+        const auto to   = round + 1 < end_round() ? entry(round + 1).sample
+                                                  : m_header->samples;
+        for (auto s = from; s < to; s++) {
+            f(m_samples[s % m_header->sample_capacity]);
+        }
+    }
+
+   private:
+    int             m_fd{-1};
+    const void*     m_map{nullptr};
+    size_t          m_size{0};
+    const header_t* m_header{nullptr};
+    const index_t*  m_index{nullptr};
+    const sample_t* m_samples{nullptr};
+
+    const index_t& entry(uint64_t round) const {
+        return m_index[round % m_header->index_capacity];
+    }
+};
+
+}  // namespace cgx::term::apps::ns_top::record
@@ -0,0 +1,118 @@
+#include "app.hpp"
+
+#include <cstring>
+
+namespace cgx::term::apps {
+
+namespace ns_trace {
+struct args_t {
+    bool        compact{false};
+    const char* action{nullptr};
+};
+
+inline constexpr auto schema = arg::schema<args_t>(
+    "trace",
+    arg::opt('b', "compact hex records instead of JSON", &args_t::compact),
+    arg::pos("action", "dump or clear", &args_t::action)
+);
+
+static constexpr const char* names[] = {
+    "ingest", "flush", "log", "init", "run", "exit", "sink",
+};
+
+// Chrome trace event format, loadable in chrome://tracing or Perfetto
+void dump_json(term_t& term) {
+    uint32_t origin = 0;
+    bool     first  = true;
+    term.print("{\"traceEvents\":[\n");
+    term.trace().for_each([&](const auto& r) {
+        if (first) {
+            origin = r.ts;
+        }
+        const auto ev = static_cast<size_t>(r.ev);
+        term.printf(
+            "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+            "\"ts\":%lu,\"dur\":%lu",
+            first ? "" : ",\n", names[ev],
+            static_cast<unsigned long>(r.ts - origin),
+            static_cast<unsigned long>(r.dur)
+        );
+        switch (r.ev) {
+            case trace_event::cmd_init:
+            case trace_event::cmd_run:
+            case trace_event::cmd_exit:
+                if (r.arg < term.commands().size()) {
+                    term.printf(
+                        ",\"args\":{\"cmd\":\"%s\"}",
+                        term.commands()[r.arg].name()
+                    );
+                }
+                break;
+            default:
+                term.printf(",\"args\":{\"bytes\":%u}", r.arg);
+                break;
+        }
+        term.print("}");
+        first = false;
+    });
+    term.print("\n]}\n");
+}
+
+// one record per line: ts(8) dur(8) event(2) arg(4), all hex
+void dump_compact(term_t& term) {
+    term.trace().for_each([&](const auto& r) {
+        term.printf(
+            "%08lx%08lx%02x%04x\n", static_cast<unsigned long>(r.ts),
+            static_cast<unsigned long>(r.dur), static_cast<unsigned>(r.ev),
+            static_cast<unsigned>(r.arg)
+        );
+    });
+}
+}  // namespace ns_trace
+
+cmd_t trace = {
+    "trace",
+    "dump or clear the hot-path trace",
+    nullptr,                            // init
+    [](auto& term, const auto* args) {  // run
+        ns_trace::args_t a{};
+        arg::line_t      line;
+        switch (ns_trace::schema.parse(args, a, line)) {
+            case arg::status::ok:
+                break;
+            case arg::status::help:
+                term.print(arg::help<ns_trace::schema>.data());
+                return cgx::term::cmd_t::ret_code::ok;
+            case arg::status::error:
+                term.print(arg::help<ns_trace::schema>.data());
+                return cgx::term::cmd_t::ret_code::error;
+        }
+
+        if constexpr (!trace_t::enabled) {
+            term.print("tracing is disabled, build with CGX_TERM_TRACE=1\n");
+            return cgx::term::cmd_t::ret_code::error;
+        }
+
+        if (a.action != nullptr && std::strcmp(a.action, "clear") == 0) {
+            term.trace().clear();
+            return cgx::term::cmd_t::ret_code::ok;
+        }
+        if (a.action == nullptr || std::strcmp(a.action, "dump") != 0) {
+            term.print(arg::help<ns_trace::schema>.data());
+            return cgx::term::cmd_t::ret_code::error;
+        }
+
+        // the dump itself would otherwise overwrite the ring it walks
+        term.trace().pause(true);
+        if (a.compact) {
+            ns_trace::dump_compact(term);
+        } else {
+            ns_trace::dump_json(term);
+        }
+        term.trace().pause(false);
+        return cgx::term::cmd_t::ret_code::ok;
+    },
+    nullptr,  // exit
+};
+
+}  // namespace cgx::term::apps
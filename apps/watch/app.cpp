@@ -0,0 +1,200 @@
+#include "app.hpp"
+
+#include <atomic>
+#include <cstring>
+
+#include "../scheduler.hpp"
+
+namespace cgx::term::apps {
+
+namespace ns_watch {
+struct args_t {
+    const char* period{nullptr};
+    const char* cmd{nullptr};
+};
+
+inline constexpr auto schema = arg::schema<args_t>(
+    "watch",
+    arg::opt('n', "refresh period in ms (500, 2s...)", &args_t::period),
+    arg::rest("cmd", "command and its arguments", &args_t::cmd)
+);
+
+static arg::status            status{arg::status::ok};
+static bool                   running{false};  // one watch per process
+static const cmd_t*           cmd{nullptr};
+static int64_t                period_us{0};
+static std::array<char, 128>  cmd_args{};
+static bool                   has_args{false};
+static std::array<char, 128>  scratch{};
+static std::array<char, 2048> output{};
+static size_t                 output_len{0};
+static bool                   truncated{false};
+static uint32_t               hash{0};
+static uint32_t               last_hash{0};
+static bool                   has_output{false};
+// set by the scheduler task, consumed by the terminal loop
+static std::atomic<bool> due{false};
+
+static const footprint_t buffers_footprint{
+    "watch", sizeof(cmd_args) + sizeof(scratch) + sizeof(output)
+};
+
+// -n in microseconds: a bare number is in milliseconds, a duration suffix
+// (us, ms, s) is taken as given
+bool parse_period(const char* s, int64_t& us) {
+    if (s == nullptr) {
+        us = 1'000'000;
+        return true;
+    }
+    const size_t len = std::strlen(s);
+    if (!parse_value(s, s + len, us)) {
+        return false;
+    }
+    const bool bare = len > 0 && s[len - 1] != 's';
+    return !bare || !__builtin_mul_overflow(us, 1000, &us);
+}
+
+// FNV-1a over everything the command prints, including what does not fit
+// in `output`
+void capture(const char* s) {
+    for (; *s != '\0'; s++) {
+        hash = (hash ^ static_cast<uint8_t>(*s)) * 16777619u;
+        if (output_len < output.size() - 1) {
+            output[output_len++] = *s;
+        } else {
+            truncated = true;
+        }
+    }
+}
+
+void refresh(term_t& term) {
+    if (cmd == nullptr) {
+        return;
+    }
+    output_len = 0;
+    truncated  = false;
+    hash       = 2166136261u;
+    // commands tokenize their arguments in place, so hand them a fresh copy
+    scratch = cmd_args;
+    term.run_captured(*cmd, has_args ? scratch.data() : nullptr, capture);
+    output[output_len] = '\0';
+
+    if (has_output && hash == last_hash) {
+        return;
+    }
+    has_output = true;
+    last_hash  = hash;
+
+    term.print("\033[2J");
+    term.print("\033[H");
+    term.print("\033[1m");
+    const bool whole_ms = period_us % 1000 == 0;
+    term.printf(
+        "Every %lld%s: %s %s (q)uit\n\n",
+        static_cast<long long>(whole_ms ? period_us / 1000 : period_us),
+        whole_ms ? "ms" : "us", cmd->name(), cmd_args.data()
+    );
+    term.print("\033[0m");
+    term.print(output.data());
+    if (truncated) {
+        term.print("\n[output truncated]\n");
+    }
+}
+}  // namespace ns_watch
+
+cmd_t watch = {
+    "watch",
+    "run a command periodically, showing output changes",
+    [](auto& term, const auto* args) {  // init
+        // another session or job owns the statics below
+        if (ns_watch::running) {
+            term.print("watch: already running\n");
+            return false;
+        }
+        ns_watch::cmd    = nullptr;
+        ns_watch::args_t a{};
+        arg::line_t      line;
+        int64_t          period = 0;
+        ns_watch::status = ns_watch::schema.parse(args, a, line);
+        if (ns_watch::status == arg::status::ok &&
+            (!ns_watch::parse_period(a.period, period) || period <= 0 ||
+             a.cmd == nullptr || a.cmd[0] == '\0')) {
+            ns_watch::status = arg::status::error;
+        }
+        if (ns_watch::status != arg::status::ok) {
+            term.print(arg::help<ns_watch::schema>.data());
+            return true;
+        }
+
+        const char* name   = a.cmd;
+        const char* params = std::strchr(name, ' ');
+        const auto  len    = params ? static_cast<size_t>(params - name)
+                                    : std::strlen(name);
+        for (const auto& cmd : term.commands()) {
+            if (std::strlen(cmd.name()) == len &&
+                std::strncmp(cmd.name(), name, len) == 0) {
+                ns_watch::cmd = &cmd;
+                break;
+            }
+        }
+        if (ns_watch::cmd == nullptr ||
+            std::strcmp(ns_watch::cmd->name(), "watch") == 0) {
+            ns_watch::cmd = nullptr;
+            term.printf(
+                "watch: cannot watch \"%.*s\"\n", static_cast<int>(len), name
+            );
+            ns_watch::status = arg::status::error;
+            return true;
+        }
+
+        ns_watch::has_args = params != nullptr;
+        ns_watch::cmd_args.fill('\0');
+        if (params != nullptr) {
+            std::strncpy(
+                ns_watch::cmd_args.data(), params + 1,
+                ns_watch::cmd_args.size() - 1
+            );
+        }
+        ns_watch::period_us  = period;
+        ns_watch::has_output = false;
+
+        ns_watch::due     = false;
+        ns_watch::running = true;
+        ns_watch::refresh(term);
+        cgx::sch::scheduler.add({
+            "watch",
+            period,
+            [] {
+                ns_watch::due = true;
+                return true;
+            },
+        });
+        return true;
+    },
+    [](auto& term, const auto* args) {  // run
+        if (ns_watch::status == arg::status::help) {
+            return cgx::term::cmd_t::ret_code::ok;
+        }
+        if (ns_watch::status == arg::status::error) {
+            return cgx::term::cmd_t::ret_code::error;
+        }
+        if (strcmp(args, "q") == 0) {
+            return cgx::term::cmd_t::ret_code::ok;
+        }
+        // the command runs on the terminal thread, which owns the sink
+        if (ns_watch::due.exchange(false)) {
+            ns_watch::refresh(term);
+        }
+        return cgx::term::cmd_t::ret_code::alive;
+    },
+    [](auto&, const auto*) {  // exit
+        if (ns_watch::cmd != nullptr) {
+            cgx::sch::scheduler.pkill("watch");
+            ns_watch::cmd     = nullptr;
+            ns_watch::running = false;
+        }
+        return true;
+    },
+};
+
+}  // namespace cgx::term::apps
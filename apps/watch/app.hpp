@@ -0,0 +1,15 @@
+#pragma once
+
+#include <functional>
+
+#include "../../term.hpp"
+
+namespace cgx::term::apps {
+namespace ns_watch {
+// runs the watched command once and forwards its output only if it changed
+// since the last refresh. Must run on the thread driving term_t::run().
+void refresh(term_t& term);
+}  // namespace ns_watch
+
+extern cmd_t watch;
+}  // namespace cgx::term::apps
@@ -0,0 +1,126 @@
+// Steady-state heap audit: links the alloc app, which replaces the global
+// allocator, and scripts a session through input() and run() -- typing and
+// line editing, history recall and Ctrl-R search, pkill over a synthetic
+// workload and top refreshes. The script runs once to warm up, then again
+// with the audit armed.
+//
+//   alloc_audit [-n=<tasks>] [-v]
+//
+// Exits non-zero if the armed pass allocated, printing the call sites;
+// resolve them with addr2line -f -C -e alloc_audit <address>.
+
+#include <cstdio>
+
+#include "../apps/alloc/app.hpp"
+#include "cli.hpp"
+#include "workload.hpp"
+
+namespace {
+struct args_t {
+    uint32_t tasks{200};
+    bool     verbose{false};
+};
+
+inline constexpr auto schema = cgx::term::arg::schema<args_t>(
+    "alloc_audit",
+    cgx::term::arg::opt('n', "synthetic tasks for pkill and top", &args_t::tasks),
+    cgx::term::arg::opt('v', "echo the session to stdout", &args_t::verbose)
+);
+
+bool   verbose = false;
+size_t printed = 0;
+
+// one step of the script: `keys` typed, then a few terminal passes with
+// the scheduler driven in between
+void type(cgx::term::term_t& term, const char* keys) {
+    for (; *keys != '\0'; keys++) {
+        term.input(*keys);
+    }
+    for (int i = 0; i < 4; i++) {
+        cgx::sch::scheduler.run_once();
+        term.run();
+    }
+}
+
+void session(cgx::term::term_t& term) {
+    // typing, editing and running commands
+    type(term, "help\r");
+    type(term, "hepl\x7f\x7f" "lp\r");
+    type(term, "mem\r");
+    type(term, "nosuchcommand arg\r");
+
+    // history recall and incremental search
+    type(term, "\033[A\033[A\r");
+    type(term, "\033[A\033[B\033[B\x03");
+    type(term, "\x12he");
+    type(term, "\x7f\x7f" "me\r");
+    type(term, "\x12zz\x07\x03");
+
+    // pkill: a glob that matches nothing, then one that takes every task
+    type(term, "pkill zz*\r");
+    type(term, "pkill -a w0*\r");
+
+    // top: forced refreshes and scheduled ones
+    type(term, "top -n=1ms\r");
+    for (int i = 0; i < 8; i++) {
+        type(term, "n");
+    }
+    type(term, "r");
+    type(term, "q");
+}
+
+// tasks for pkill to kill; the slots the last pass freed are reused
+void spawn(uint32_t tasks) {
+    cgx::sch::sim::workload_t workload{};
+    workload.tasks    = tasks;
+    workload.max_load = 0;
+    cgx::sch::sim::spawn(cgx::sch::scheduler, workload);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::array<char, 256> line;
+    cgx::term::sim::join_args(argc, argv, line);
+    args_t args{};
+    if (schema.parse(line.data(), args) != cgx::term::arg::status::ok) {
+        std::fputs(cgx::term::arg::help<schema>.data(), stderr);
+        return 1;
+    }
+    verbose = args.verbose;
+
+    namespace ns_alloc = cgx::term::apps::ns_alloc;
+    cgx::term::term_t term([](const char* s) {
+        printed += std::strlen(s);
+        if (verbose) {
+            std::fputs(s, stdout);
+        }
+    });
+    for (const auto& cmd : cgx::term::sim::apps()) {
+        term.add(cmd);
+    }
+    term.add(cgx::term::apps::alloc);
+
+    // the first pass may allocate: stdio buffers, the scheduler's lists
+    spawn(args.tasks);
+    session(term);
+    const auto warm_up = ns_alloc::allocations();
+
+    spawn(args.tasks);
+    ns_alloc::arm();
+    session(term);
+    ns_alloc::disarm();
+
+    const auto violations = ns_alloc::violations();
+    std::fflush(stdout);
+    std::printf(
+        "%zu B printed, %zu allocations warming up, %zu in steady state\n",
+        printed, warm_up, violations
+    );
+    const auto& sites = ns_alloc::sites();
+    for (size_t i = 0; i < violations && i < sites.size(); i++) {
+        std::printf(
+            "  %2zu: %6zu B from %p\n", i, sites[i].size, sites[i].caller
+        );
+    }
+    return violations == 0 ? 0 : 1;
+}
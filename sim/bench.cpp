@@ -0,0 +1,162 @@
+// Throughput benchmark for the console server: starts a server_t on its own
+// thread, connects `-c` clients that each run `help` `-r` times back to
+// back, and reports commands per second and the per-command latency.
+//
+//   term_bench [-c=<clients>] [-r=<rounds>]
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "cli.hpp"
+#include "server.hpp"
+
+namespace {
+struct args_t {
+    uint32_t clients{32};
+    uint32_t rounds{200};
+};
+
+inline constexpr auto schema = cgx::term::arg::schema<args_t>(
+    "term_bench",
+    cgx::term::arg::opt('c', "concurrent clients", &args_t::clients),
+    cgx::term::arg::opt('r', "commands per client", &args_t::rounds)
+);
+
+using steady_t = std::chrono::steady_clock;
+
+struct client_t {
+    std::vector<uint32_t> latency_us{};
+    size_t                bytes{0};
+    bool                  ok{false};
+};
+
+// reads until the received data ends with `prompt`
+bool wait_prompt(int fd, const char* prompt, client_t& client) {
+    const auto len = std::strlen(prompt);
+    char       tail[16]{};
+    size_t     have = 0;
+    char       buf[4096];
+    for (;;) {
+        const auto n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            return false;
+        }
+        client.bytes += n;
+        for (ssize_t i = 0; i < n; i++) {
+            std::memmove(tail, tail + 1, sizeof(tail) - 1);
+            tail[sizeof(tail) - 1] = buf[i];
+        }
+        have += n;
+        if (have >= len &&
+            std::memcmp(tail + sizeof(tail) - len, prompt, len) == 0) {
+            return true;
+        }
+    }
+}
+
+void run_client(const char* path, uint32_t rounds, client_t& client) {
+    const int   fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path);
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) !=
+            0 ||
+        !wait_prompt(fd, "> ", client)) {
+        ::close(fd);
+        return;
+    }
+    client.latency_us.reserve(rounds);
+    for (uint32_t i = 0; i < rounds; i++) {
+        const auto start = steady_t::now();
+        if (::write(fd, "help\r", 5) != 5 ||
+            !wait_prompt(fd, "\033[2K> ", client)) {
+            ::close(fd);
+            return;
+        }
+        client.latency_us.push_back(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                steady_t::now() - start
+            )
+                .count()
+        );
+    }
+    client.ok = true;
+    ::close(fd);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::array<char, 256> line;
+    cgx::term::sim::join_args(argc, argv, line);
+    args_t args{};
+    if (schema.parse(line.data(), args) != cgx::term::arg::status::ok) {
+        std::fputs(cgx::term::arg::help<schema>.data(), stderr);
+        return 1;
+    }
+
+    char path[64];
+    std::snprintf(path, sizeof(path), "/tmp/term_bench.%d", ::getpid());
+    const auto               cmds = cgx::term::sim::apps();
+    cgx::term::sim::server_t server{path, cmds, args.clients};
+    if (!server.listen()) {
+        std::perror("term_bench");
+        return 1;
+    }
+    std::atomic<bool> running{true};
+    std::thread       loop([&] {
+        while (running) {
+            server.poll(1);
+        }
+    });
+
+    std::vector<client_t>    clients(args.clients);
+    std::vector<std::thread> threads;
+    const auto               start = steady_t::now();
+    for (auto& client : clients) {
+        threads.emplace_back(run_client, path, args.rounds, std::ref(client));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    const auto elapsed =
+        std::chrono::duration<double>(steady_t::now() - start).count();
+    running = false;
+    loop.join();
+
+    std::vector<uint32_t> latency;
+    size_t                bytes  = 0;
+    size_t                failed = 0;
+    for (const auto& client : clients) {
+        failed += client.ok ? 0 : 1;
+        bytes += client.bytes;
+        latency.insert(
+            latency.end(), client.latency_us.begin(), client.latency_us.end()
+        );
+    }
+    std::sort(latency.begin(), latency.end());
+    const auto pct = [&](double p) {
+        return latency.empty() ? 0u
+                               : latency[static_cast<size_t>(
+                                     p * (latency.size() - 1)
+                                 )];
+    };
+    const auto& st = server.stats();
+    std::printf(
+        "%u clients x %u cmds in %.3f s (%u failed)\n"
+        "  %.0f cmds/s, %.2f MB/s out, %zu writes (%.1f cmds/write)\n"
+        "  latency p50 %u us, p99 %u us, max %u us\n",
+        args.clients, args.rounds, elapsed, static_cast<unsigned>(failed),
+        latency.size() / elapsed, bytes / elapsed / 1e6, st.writes,
+        st.writes == 0 ? 0.0 : double(latency.size()) / st.writes, pct(0.5),
+        pct(0.99), latency.empty() ? 0u : latency.back()
+    );
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+// Bits shared by the simulator executables.
+
+#include <cstdio>
+
+#include "../apps/clear/app.hpp"
+#include "../apps/help/app.hpp"
+#include "../apps/jobs/app.hpp"
+#include "../apps/mem/app.hpp"
+#include "../apps/pkill/app.hpp"
+#include "../apps/top/app.hpp"
+#include "../apps/trace/app.hpp"
+#include "../apps/watch/app.hpp"
+#include "../term.hpp"
+
+namespace cgx::term::sim {
+
+// argv joined back into one line for arg::schema_t::parse
+template <size_t N>
+void join_args(int argc, char** argv, std::array<char, N>& line) {
+    size_t len = 0;
+    line.fill('\0');
+    for (int i = 1; i < argc && len < N; i++) {
+        len += std::snprintf(
+            line.data() + len, N - len, "%s%s", i > 1 ? " " : "", argv[i]
+        );
+    }
+}
+
+// every app that runs on a host; alloc is left out as it replaces the
+// global allocator
+inline term_t::cmds_t apps() {
+    return {
+        cgx::term::apps::help,  cgx::term::apps::clear,
+        cgx::term::apps::top,   cgx::term::apps::pkill,
+        cgx::term::apps::watch, cgx::term::apps::mem,
+        cgx::term::apps::trace, cgx::term::apps::jobs,
+        cgx::term::apps::fg,    cgx::term::apps::kill,
+    };
+}
+
+}  // namespace cgx::term::sim
@@ -0,0 +1,172 @@
+// Benchmark for the input fast path: walks a 4 KB paste the way term_t's
+// ingest does -- find the next control byte, take the plain run before it,
+// step over the control -- once with find_control() and once with the
+// portable find_control_scalar(), and reports the throughput of each. Then
+// types pastes into a term_t with input() and run(), once with plain runs
+// copied into the line in one step and once a byte at a time through the
+// decoder, as before the fast path.
+//
+//   ingest_bench [-r=<rounds>] [-e=<rounds>]
+//
+// The walks time 72-byte lines ending in CR and one unbroken run of text;
+// term_t gets the lines and 1000-byte lines, which still fit on its line.
+// Exits non-zero if the two paths disagree. Numbers only mean something in
+// an optimized build (CMAKE_BUILD_TYPE=Release).
+
+#include <chrono>
+#include <cstdio>
+
+#include "cli.hpp"
+
+namespace {
+struct args_t {
+    uint32_t rounds{100'000};
+    uint32_t typed{2'000};
+};
+
+inline constexpr auto schema = cgx::term::arg::schema<args_t>(
+    "ingest_bench",
+    cgx::term::arg::opt('r', "walks of each paste", &args_t::rounds),
+    cgx::term::arg::opt('e', "pastes typed into term_t", &args_t::typed)
+);
+
+using steady_t = std::chrono::steady_clock;
+
+constexpr size_t paste_size = 4096;
+
+// keeps the walks' results alive
+volatile size_t consumed = 0;
+
+// plain runs found in the paste, adding their bytes to `plain`
+template <typename F>
+size_t walk(const char* s, size_t n, F&& find, size_t& plain) {
+    size_t runs = 0;
+    for (size_t i = 0; i < n;) {
+        const size_t k = find(s + i, n - i);
+        plain += k;
+        runs += k > 0 ? 1 : 0;
+        i += k + 1;
+    }
+    return runs;
+}
+
+template <typename F>
+double time_walk(const char* s, uint32_t rounds, F&& find, size_t& runs) {
+    size_t     plain = 0;
+    const auto start = steady_t::now();
+    for (uint32_t r = 0; r < rounds; r++) {
+        // the paste may have changed, so every round walks it again
+        asm volatile("" : : "r"(s) : "memory");
+        runs = walk(s, paste_size, find, plain);
+    }
+    const auto secs =
+        std::chrono::duration<double>(steady_t::now() - start).count();
+    consumed = plain;
+    return secs;
+}
+
+bool report(const char* name, const char* paste, uint32_t rounds) {
+    size_t     simd_runs   = 0;
+    size_t     scalar_runs = 0;
+    const auto simd        = time_walk(
+        paste, rounds,
+        [](const char* s, size_t n) { return cgx::term::find_control(s, n); },
+        simd_runs
+    );
+    const auto scalar = time_walk(
+        paste, rounds,
+        [](const char* s, size_t n) {
+            return cgx::term::find_control_scalar(s, n);
+        },
+        scalar_runs
+    );
+    const double mb = double(paste_size) * rounds / 1e6;
+    std::printf(
+        "%-6s %4zu runs: find_control %8.0f MB/s, scalar %8.0f MB/s, "
+        "x%.1f\n",
+        name, simd_runs, mb / simd, mb / scalar, scalar / simd
+    );
+    if (simd_runs != scalar_runs) {
+        std::fprintf(
+            stderr, "ingest_bench: %s: %zu runs vs %zu scalar\n", name,
+            simd_runs, scalar_runs
+        );
+        return false;
+    }
+    return true;
+}
+// the input ring holds 1 KB, so the paste goes in in chunks, with a run()
+// for every line a chunk completes and one for the rest of it
+double time_term(
+    const char* s, uint32_t rounds, bool plain_runs, size_t& printed
+) {
+    constexpr size_t  chunk = 512;
+    size_t            out   = 0;
+    cgx::term::term_t term([&out](const char* p) { out += std::strlen(p); });
+    term.enable_plain_runs(plain_runs);
+    const auto start = steady_t::now();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < paste_size; i += chunk) {
+            size_t lines = 0;
+            for (size_t j = i; j < i + chunk; j++) {
+                term.input(s[j]);
+                lines += s[j] == '\r' ? 1 : 0;
+            }
+            for (size_t k = 0; k <= lines; k++) {
+                term.run();
+            }
+        }
+    }
+    const auto secs =
+        std::chrono::duration<double>(steady_t::now() - start).count();
+    printed = out;
+    return secs;
+}
+
+bool report_term(const char* name, const char* paste, uint32_t rounds) {
+    size_t     fast_printed = 0;
+    size_t     byte_printed = 0;
+    const auto fast         = time_term(paste, rounds, true, fast_printed);
+    const auto byte         = time_term(paste, rounds, false, byte_printed);
+    const double mb         = double(paste_size) * rounds / 1e6;
+    std::printf(
+        "%-6s term_t: plain runs %8.0f MB/s, per byte %8.0f MB/s, x%.1f\n",
+        name, mb / fast, mb / byte, byte / fast
+    );
+    if (fast_printed != byte_printed) {
+        std::fprintf(
+            stderr, "ingest_bench: %s: %zu B printed vs %zu per byte\n", name,
+            fast_printed, byte_printed
+        );
+        return false;
+    }
+    return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::array<char, 256> line;
+    cgx::term::sim::join_args(argc, argv, line);
+    args_t args{};
+    if (schema.parse(line.data(), args) != cgx::term::arg::status::ok) {
+        std::fputs(cgx::term::arg::help<schema>.data(), stderr);
+        return 1;
+    }
+
+    static char lines[paste_size];
+    static char text[paste_size];
+    static char wide[paste_size];
+    for (size_t i = 0; i < paste_size; i++) {
+        text[i]  = static_cast<char>(' ' + i % 95);
+        lines[i] = i % 73 == 72 ? '\r' : text[i];
+        wide[i]  = i % 1000 == 999 ? '\r' : text[i];
+    }
+
+    std::printf("%zu B paste, %u rounds\n", paste_size, args.rounds);
+    bool ok = report("lines", lines, args.rounds) &
+              report("text", text, args.rounds);
+    std::printf("%zu B paste, %u typed\n", paste_size, args.typed);
+    ok = ok & report_term("lines", lines, args.typed) &
+         report_term("wide", wide, args.typed);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+// Terminal simulator: runs term_t and the apps on stdin/stdout against the
+// host scheduler, optionally with a synthetic workload.
+//
+//   term_sim [-n=<tasks>] [-p=<max period>] [-l=<max load>]
+//
+// Type "exit" to quit.
+
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+
+#include "cli.hpp"
+#include "workload.hpp"
+
+namespace {
+struct args_t {
+    uint32_t           tasks{0};
+    cgx::sch::time_t   max_period{100'000};
+    cgx::sch::time_t   max_load{20};
+};
+
+inline constexpr auto schema = cgx::term::arg::schema<args_t>(
+    "term_sim",
+    cgx::term::arg::opt('n', "synthetic tasks to spawn", &args_t::tasks),
+    cgx::term::arg::opt('p', "max task period (1ms, 2s...)", &args_t::max_period),
+    cgx::term::arg::opt('l', "max busy time per run (us)", &args_t::max_load)
+);
+
+std::atomic<bool> running{true};
+
+struct raw_mode_t {
+    termios saved{};
+    bool    active{false};
+
+    raw_mode_t() {
+        if (tcgetattr(STDIN_FILENO, &saved) != 0) {
+            return;
+        }
+        termios raw = saved;
+        raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+        raw.c_iflag &= ~(IXON | ICRNL);
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        active = true;
+    }
+    ~raw_mode_t() {
+        if (active) {
+            tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+        }
+    }
+};
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::array<char, 256> line;
+    cgx::term::sim::join_args(argc, argv, line);
+    args_t args{};
+    if (schema.parse(line.data(), args) != cgx::term::arg::status::ok) {
+        std::fputs(cgx::term::arg::help<schema>.data(), stderr);
+        return 1;
+    }
+
+    cgx::sch::sim::workload_t workload{};
+    workload.tasks      = args.tasks;
+    workload.max_period = args.max_period;
+    workload.max_load   = args.max_load;
+    if (workload.min_period > workload.max_period) {
+        workload.min_period = workload.max_period;
+    }
+    const auto spawned = cgx::sch::sim::spawn(cgx::sch::scheduler, workload);
+    cgx::sch::scheduler.start();
+
+    cgx::term::term_t term([](const char* s) {
+        std::fputs(s, stdout);
+        std::fflush(stdout);
+    });
+    for (const auto& cmd : cgx::term::sim::apps()) {
+        term.add(cmd);
+    }
+    cgx::term::apps::ns_jobs::use_scheduler(term);
+    term.add({
+        "exit",
+        "quit the simulator",
+        nullptr,
+        [](auto&, const auto*) {
+            running = false;
+            return cgx::term::cmd_t::ret_code::ok;
+        },
+        nullptr,
+    });
+
+    raw_mode_t raw{};
+    term.printf("term_sim: %zu synthetic tasks\n> ", spawned);
+
+    pollfd fd{STDIN_FILENO, POLLIN, 0};
+    while (running) {
+        if (poll(&fd, 1, 1) > 0) {
+            char       buf[256];
+            const auto n = read(STDIN_FILENO, buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            for (ssize_t i = 0; i < n; i++) {
+                term.input(buf[i]);
+            }
+        }
+        term.run();
+    }
+    term.print("\n");
+    cgx::sch::scheduler.stop();
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Benchmark for argument number parsing: converts a corpus of 1024 numbers,
+// three decimal to one hex, with parse_value() -- std::from_chars plus
+// the unit suffix and range checks -- and with std::atoi and std::strtoul,
+// and reports the cost per value of each.
+//
+//   parse_bench [-r=<rounds>]
+//
+// Exits non-zero if parse_value() and strtoul disagree on a value. Numbers
+// only mean something in an optimized build (CMAKE_BUILD_TYPE=Release).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "cli.hpp"
+
+namespace {
+struct args_t {
+    uint32_t rounds{2'000};
+};
+
+inline constexpr auto schema = cgx::term::arg::schema<args_t>(
+    "parse_bench",
+    cgx::term::arg::opt('r', "passes over the corpus", &args_t::rounds)
+);
+
+using steady_t = std::chrono::steady_clock;
+
+// keeps the conversions' results alive
+volatile uint64_t consumed = 0;
+
+struct corpus_t {
+    std::vector<std::array<char, 16>> text{};
+    std::vector<const char*>          end{};
+};
+
+corpus_t make_corpus(size_t n) {
+    corpus_t                                c;
+    std::minstd_rand                        rng{1};
+    std::uniform_int_distribution<uint32_t> digits{1, 10};
+    for (size_t i = 0; i < n; i++) {
+        // an even spread of lengths, not of values, as typed arguments are
+        uint64_t v = rng() % 10;
+        for (auto d = digits(rng); d > 1; d--) {
+            v = v * 10 + rng() % 10;
+        }
+        auto& t = c.text.emplace_back();
+        std::snprintf(
+            t.data(), t.size(), i % 4 == 3 ? "0x%x" : "%u",
+            static_cast<uint32_t>(v)
+        );
+    }
+    for (const auto& t : c.text) {
+        c.end.push_back(t.data() + std::strlen(t.data()));
+    }
+    return c;
+}
+
+template <typename F>
+double time_ns(const corpus_t& c, uint32_t rounds, F&& convert) {
+    uint64_t   sum   = 0;
+    const auto start = steady_t::now();
+    for (uint32_t r = 0; r < rounds; r++) {
+        // the corpus may have changed, so every round converts it again
+        asm volatile("" : : "r"(c.text.data()) : "memory");
+        for (size_t i = 0; i < c.text.size(); i++) {
+            sum += convert(c.text[i].data(), c.end[i]);
+        }
+    }
+    const auto secs =
+        std::chrono::duration<double>(steady_t::now() - start).count();
+    consumed = sum;
+    return secs * 1e9 / (double(rounds) * c.text.size());
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::array<char, 256> line;
+    cgx::term::sim::join_args(argc, argv, line);
+    args_t args{};
+    if (schema.parse(line.data(), args) != cgx::term::arg::status::ok) {
+        std::fputs(cgx::term::arg::help<schema>.data(), stderr);
+        return 1;
+    }
+
+    const auto c = make_corpus(1024);
+    for (size_t i = 0; i < c.text.size(); i++) {
+        uint32_t   parsed = 0;
+        const bool ok =
+            cgx::term::parse_value(c.text[i].data(), c.end[i], parsed);
+        const auto expected = std::strtoul(c.text[i].data(), nullptr, 0);
+        if (!ok || parsed != expected) {
+            std::fprintf(
+                stderr, "parse_bench: \"%s\": parse_value %u, strtoul %lu\n",
+                c.text[i].data(), parsed, expected
+            );
+            return 1;
+        }
+    }
+
+    const auto ns_parse =
+        time_ns(c, args.rounds, [](const char* s, const char* e) {
+            uint32_t v = 0;
+            cgx::term::parse_value(s, e, v);
+            return v;
+        });
+    // reads the hex values as 0, as an atoi-based parser would
+    const auto ns_atoi =
+        time_ns(c, args.rounds, [](const char* s, const char*) {
+            return static_cast<uint32_t>(std::atoi(s));
+        });
+    const auto ns_strtoul =
+        time_ns(c, args.rounds, [](const char* s, const char*) {
+            return static_cast<uint32_t>(std::strtoul(s, nullptr, 0));
+        });
+
+    std::printf(
+        "%zu values, %u rounds\n"
+        "  parse_value %6.1f ns/value\n"
+        "  atoi        %6.1f ns/value\n"
+        "  strtoul     %6.1f ns/value\n",
+        c.text.size(), args.rounds, ns_parse, ns_atoi, ns_strtoul
+    );
+    return 0;
+}
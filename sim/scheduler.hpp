@@ -0,0 +1,427 @@
+#pragma once
+
+// Host stand-in for cgx::sch, the scheduler the apps are written against.
+// It implements the part of the interface the apps use -- threads(),
+// lock/unlock, watch(), task iteration, add, pkill and reset_stats -- on top
+// of std::thread, so the apps build and can be load-tested on Linux.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cgx::sch {
+
+using time_t = long long;  // us
+
+inline time_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()
+    )
+        .count();
+}
+
+template <typename T>
+class stats_t {
+   public:
+    void add(T value) {
+        m_sum += value;
+        m_count++;
+        if (value < m_min) {
+            m_min = value;
+        }
+        if (value > m_max) {
+            m_max = value;
+        }
+    }
+
+    T mean() const {
+        return m_count == 0 ? 0 : m_sum / m_count;
+    }
+    // numeric_limits max() until the first sample, like the real scheduler
+    T min() const {
+        return m_min;
+    }
+    // numeric_limits lowest() until the first sample
+    T max() const {
+        return m_max;
+    }
+
+    void reset() {
+        *this = {};
+    }
+
+   private:
+    T m_sum{0};
+    T m_count{0};
+    T m_min{std::numeric_limits<T>::max()};
+    T m_max{std::numeric_limits<T>::lowest()};
+};
+
+// duration of every pass of a thread's loop
+class watch_t {
+   public:
+    void start() {
+        m_start = now_us();
+    }
+    void stop() {
+        m_duration.add(now_us() - m_start);
+    }
+    const stats_t<time_t>& duration() const {
+        return m_duration;
+    }
+    void reset() {
+        m_duration.reset();
+    }
+
+   private:
+    time_t          m_start{0};
+    stats_t<time_t> m_duration{};
+};
+
+class task_t {
+   public:
+    enum class status_t {
+        running,
+        stopped,
+        paused,
+        delayed,
+        invalid,
+    };
+
+    // returning false from the task removes it
+    using fn_t = std::function<bool()>;
+
+    task_t() = default;
+    task_t(const char* name, time_t period, fn_t fn)
+        : m_period(period), m_fn(std::move(fn)), m_status(status_t::running) {
+        size_t len = std::strlen(name);
+        if (len >= m_name.size() - 1) {
+            len = m_name.size() - 1;
+        }
+        std::memcpy(m_name.data(), name, len);
+        m_name[len] = '\0';
+    }
+
+    const std::array<char, 16>& name() const {
+        return m_name;
+    }
+    status_t status() const {
+        return m_status;
+    }
+    time_t period() const {
+        return m_period;
+    }
+    const stats_t<time_t>& actual_period() const {
+        return m_actual_period;
+    }
+    const stats_t<time_t>& run_time() const {
+        return m_run_time;
+    }
+    time_t ticks_left() const {
+        const auto left = m_next - now_us();
+        return left > 0 ? left : 0;
+    }
+
+    void kill() {
+        m_status = status_t::invalid;
+        m_fn     = nullptr;
+    }
+    void pause() {
+        if (m_status != status_t::invalid) {
+            m_status = status_t::paused;
+        }
+    }
+    void resume() {
+        if (m_status == status_t::paused) {
+            m_status = status_t::running;
+        }
+    }
+
+    void reset_stats() {
+        m_actual_period.reset();
+        m_run_time.reset();
+    }
+
+    explicit operator bool() const {
+        return m_status != status_t::invalid;
+    }
+
+   private:
+    friend class thread_t;
+
+    std::array<char, 16> m_name{};
+    time_t               m_period{0};
+    fn_t                 m_fn{};
+    status_t             m_status{status_t::invalid};
+    time_t               m_next{0};
+    time_t               m_last{0};
+    stats_t<time_t>      m_actual_period{};
+    stats_t<time_t>      m_run_time{};
+    uint64_t             m_serial{0};  // from thread_t::add, unique per task
+
+    // takes the task's next period if it is due at `now`. `next` is set to
+    // when it is due next. The caller then runs m_fn and reports to finish().
+    bool schedule(time_t now, time_t& next) {
+        if (m_status == status_t::invalid || m_status == status_t::paused ||
+            m_status == status_t::stopped) {
+            next = std::numeric_limits<time_t>::max();
+            return false;
+        }
+        if (now < m_next) {
+            next = m_next;
+            return false;
+        }
+        if (m_last != 0) {
+            m_actual_period.add(now - m_last);
+        }
+        // more than a full period late
+        m_status = m_last != 0 && now - m_next > m_period ? status_t::delayed
+                                                          : status_t::running;
+        m_last   = now;
+        m_next   = (m_next == 0 ? now : m_next) + m_period;
+        if (m_next < now) {
+            m_next = now + m_period;
+        }
+        next = m_next;
+        return true;
+    }
+
+    void finish(time_t run_time, bool keep) {
+        m_run_time.add(run_time);
+        if (!keep) {
+            kill();
+        }
+    }
+};
+
+class thread_t {
+   public:
+    // tasks live in a deque so adding one from inside a running task does not
+    // move the others
+    using container_t = std::deque<task_t>;
+
+    void lock() {
+        m_mutex.lock();
+    }
+    void unlock() {
+        m_mutex.unlock();
+    }
+
+    watch_t watch() const {
+        return m_watch;
+    }
+
+    // valid tasks
+    size_t size() {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        size_t                                n = 0;
+        for (const auto& task : m_tasks) {
+            n += task ? 1 : 0;
+        }
+        return n;
+    }
+
+    container_t::iterator begin() {
+        return m_tasks.begin();
+    }
+    container_t::iterator end() {
+        return m_tasks.end();
+    }
+
+    void add(task_t task) {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        task.m_serial = ++m_serial;
+        for (auto& slot : m_tasks) {
+            if (!slot) {
+                slot = std::move(task);
+                return;
+            }
+        }
+        m_tasks.push_back(std::move(task));
+    }
+
+    bool pkill(const char* name) {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        for (auto& task : m_tasks) {
+            if (task && std::strcmp(task.name().data(), name) == 0) {
+                task.kill();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void reset_stats() {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        m_watch.reset();
+        for (auto& task : m_tasks) {
+            task.reset_stats();
+        }
+    }
+
+    // one pass over the tasks. Returns when the next one is due.
+    //
+    // The due tasks are picked under the mutex but run without it: a task
+    // may lock other threads, e.g. top reading their stats, and holding our
+    // own mutex meanwhile would deadlock with a task there doing the same.
+    time_t run_once() {
+        auto next = std::numeric_limits<time_t>::max();
+        m_due.clear();
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            m_watch.start();
+            const auto now = now_us();
+            for (size_t i = 0; i < m_tasks.size(); i++) {
+                time_t due;
+                if (m_tasks[i].schedule(now, due)) {
+                    // a copy, the task may be killed while it runs
+                    m_due.push_back({i, m_tasks[i].m_serial, m_tasks[i].m_fn});
+                }
+                if (due < next) {
+                    next = due;
+                }
+            }
+        }
+        for (auto& due : m_due) {
+            const auto start = now_us();
+            const bool keep  = due.fn();
+            const auto took  = now_us() - start;
+
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            // killed and its slot reused while it ran
+            auto& task = m_tasks[due.index];
+            if (task && task.m_serial == due.serial) {
+                task.finish(took, keep);
+            }
+        }
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        m_watch.stop();
+        return next;
+    }
+
+   private:
+    struct due_t {
+        size_t       index;
+        uint64_t     serial;
+        task_t::fn_t fn;
+    };
+
+    std::recursive_mutex m_mutex{};
+    container_t          m_tasks{};
+    watch_t              m_watch{};
+    uint64_t             m_serial{0};
+    std::vector<due_t>   m_due{};  // tasks picked by the running pass
+};
+
+class scheduler_t {
+   public:
+    using time_t = cgx::sch::time_t;
+
+    static constexpr size_t max_threads = 4;
+
+    scheduler_t() {
+        for (auto& thread : m_threads) {
+            thread = std::make_unique<thread_t>();
+        }
+    }
+    ~scheduler_t() {
+        stop();
+    }
+
+    const auto& threads() const {
+        return m_threads;
+    }
+
+    // on the thread with the fewest tasks
+    bool add(task_t task) {
+        size_t best      = 0;
+        size_t best_size = std::numeric_limits<size_t>::max();
+        for (size_t i = 0; i < m_threads.size(); i++) {
+            const auto size = m_threads[i]->size();
+            if (size < best_size) {
+                best      = i;
+                best_size = size;
+            }
+        }
+        return add(std::move(task), best);
+    }
+
+    bool add(task_t task, size_t thread) {
+        if (thread >= m_threads.size() || !task) {
+            return false;
+        }
+        m_threads[thread]->add(std::move(task));
+        return true;
+    }
+
+    // kills the first task called `name`
+    bool pkill(const char* name) {
+        for (auto& thread : m_threads) {
+            if (thread->pkill(name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void reset_stats() {
+        for (auto& thread : m_threads) {
+            thread->reset_stats();
+        }
+    }
+
+    // one pass of every thread on the caller's thread, for deterministic runs
+    void run_once() {
+        for (auto& thread : m_threads) {
+            thread->run_once();
+        }
+    }
+
+    // one std::thread per scheduler thread
+    void start() {
+        if (m_running.exchange(true)) {
+            return;
+        }
+        for (size_t i = 0; i < m_threads.size(); i++) {
+            m_workers[i] = std::thread([this, i] {
+                while (m_running) {
+                    const auto next = m_threads[i]->run_once();
+                    const auto wait = next - now_us();
+                    // wake at least every ms to pick up new tasks
+                    std::this_thread::sleep_for(std::chrono::microseconds(
+                        wait < 0 ? 0 : (wait > 1000 ? 1000 : wait)
+                    ));
+                }
+            });
+        }
+    }
+
+    void stop() {
+        if (!m_running.exchange(false)) {
+            return;
+        }
+        for (auto& worker : m_workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+   private:
+    std::array<std::unique_ptr<thread_t>, max_threads> m_threads{};
+    std::array<std::thread, max_threads>               m_workers{};
+    std::atomic<bool>                                  m_running{false};
+};
+
+inline scheduler_t scheduler{};
+
+}  // namespace cgx::sch
@@ -0,0 +1,258 @@
+#pragma once
+
+// Unix-domain-socket console server. Every client gets its own term_t
+// session (line, history and alive command) running one shared command
+// table. One thread drives everything from an epoll loop; what a session
+// prints during a pass is batched and sent with a single write().
+//
+// Apps keep their state in statics, so those that stay alive (top, watch)
+// run one instance per process: while one session has them running, other
+// sessions are told they are busy.
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "../term.hpp"
+
+namespace cgx::term::sim {
+
+class server_t {
+   public:
+    struct stats_t {
+        size_t accepted{0};
+        size_t closed{0};
+        size_t bytes_in{0};
+        size_t bytes_out{0};
+        size_t writes{0};
+        size_t dropped{0};  // bytes not queued, the client was too far behind
+    };
+
+    // output held for a client that is not reading before it is dropped
+    static constexpr size_t max_pending = 64 * 1024;
+
+    server_t(const char* path, const term_t::cmds_t& cmds, size_t max_sessions)
+        : m_path(path), m_cmds(cmds), m_max_sessions(max_sessions) {
+    }
+    ~server_t() {
+        for (auto& [fd, session] : m_sessions) {
+            ::close(fd);
+        }
+        if (m_epoll >= 0) {
+            ::close(m_epoll);
+        }
+        if (m_listen >= 0) {
+            ::close(m_listen);
+            ::unlink(m_path.c_str());
+        }
+    }
+
+    server_t(const server_t&)            = delete;
+    server_t& operator=(const server_t&) = delete;
+
+    bool listen() {
+        sockaddr_un addr{};
+        if (m_path.size() >= sizeof(addr.sun_path)) {
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, m_path.c_str());
+
+        m_listen = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (m_listen < 0) {
+            return false;
+        }
+        ::unlink(m_path.c_str());
+        const auto* sa = reinterpret_cast<const sockaddr*>(&addr);
+        if (::bind(m_listen, sa, sizeof(addr)) != 0 ||
+            ::listen(m_listen, 64) != 0) {
+            return false;
+        }
+        m_epoll = ::epoll_create1(0);
+        if (m_epoll < 0) {
+            return false;
+        }
+        epoll_event ev{};
+        ev.events  = EPOLLIN;
+        ev.data.fd = m_listen;
+        return ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_listen, &ev) == 0;
+    }
+
+    // one pass: waits up to `timeout_ms` for socket events, feeds input to
+    // the sessions, runs every session once and flushes their output
+    void poll(int timeout_ms) {
+        std::array<epoll_event, 64> events;
+        const int n =
+            ::epoll_wait(m_epoll, events.data(), events.size(), timeout_ms);
+        for (int i = 0; i < n; i++) {
+            const auto fd = events[i].data.fd;
+            if (fd == m_listen) {
+                accept();
+                continue;
+            }
+            auto it = m_sessions.find(fd);
+            if (it == m_sessions.end()) {
+                continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                read(*it->second);
+            }
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                it->second->closing = true;
+            }
+        }
+
+        for (auto it = m_sessions.begin(); it != m_sessions.end();) {
+            auto& session = *it->second;
+            if (!session.closing) {
+                session.term.run();
+                write(session);
+            }
+            if (session.closing) {
+                end(session);
+                ::close(session.fd);
+                m_stats.closed++;
+                it = m_sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    size_t sessions() const {
+        return m_sessions.size();
+    }
+    const stats_t& stats() const {
+        return m_stats;
+    }
+
+   private:
+    struct session_t {
+        int         fd;
+        std::string out{};
+        size_t      sent{0};         // bytes of `out` already written
+        bool        waiting{false};  // EPOLLOUT armed
+        bool        closing{false};
+        term_t      term;
+
+        session_t(int fd, const term_t::cmds_t& cmds, stats_t& stats)
+            : fd(fd),
+              term(
+                  [this, &stats](const char* s) {
+                      const auto len = std::strlen(s);
+                      if (out.size() - sent + len > max_pending) {
+                          stats.dropped += len;
+                          return;
+                      }
+                      out.append(s, len);
+                  },
+                  cmds
+              ) {
+        }
+    };
+
+    std::string           m_path;
+    const term_t::cmds_t& m_cmds;
+    size_t                m_max_sessions;
+    int                   m_listen{-1};
+    int                   m_epoll{-1};
+    stats_t               m_stats{};
+
+    // term_t is neither copyable nor movable
+    std::unordered_map<int, std::unique_ptr<session_t>> m_sessions{};
+
+    void accept() {
+        for (;;) {
+            const int fd = ::accept4(m_listen, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd < 0) {
+                return;
+            }
+            if (m_sessions.size() >= m_max_sessions) {
+                static constexpr char full[] = "server full\n";
+                (void)!::write(fd, full, sizeof(full) - 1);
+                ::close(fd);
+                continue;
+            }
+            epoll_event ev{};
+            ev.events  = EPOLLIN;
+            ev.data.fd = fd;
+            if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                ::close(fd);
+                continue;
+            }
+            auto session = std::make_unique<session_t>(fd, m_cmds, m_stats);
+            session->term.print("> ");
+            m_sessions.emplace(fd, std::move(session));
+            m_stats.accepted++;
+        }
+    }
+
+    // one read per pass so the session's 1 KB input ring is drained by run()
+    // before more arrives; epoll is level-triggered and reports the rest
+    void read(session_t& session) {
+        char       buf[512];
+        const auto n = ::read(session.fd, buf, sizeof(buf));
+        if (n > 0) {
+            m_stats.bytes_in += n;
+            for (ssize_t i = 0; i < n; i++) {
+                session.term.input(buf[i]);
+            }
+            return;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            session.closing = true;
+        }
+    }
+
+    // a client going away is a Ctrl-C: the alive command and any background
+    // jobs get their exit hooks, so their scheduler tasks do not outlive the
+    // session. What they print is dropped with the session.
+    void end(session_t& session) {
+        session.term.input('\x03');
+        session.term.run();
+        for (size_t id = 1; id <= term_t::max_jobs; id++) {
+            session.term.kill_job(id);
+        }
+    }
+
+    void write(session_t& session) {
+        if (session.sent < session.out.size()) {
+            const auto n = ::send(
+                session.fd, session.out.data() + session.sent,
+                session.out.size() - session.sent, MSG_NOSIGNAL
+            );
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                session.closing = true;
+                return;
+            }
+            if (n > 0) {
+                session.sent += n;
+                m_stats.bytes_out += n;
+                m_stats.writes++;
+            }
+        }
+        const bool pending = session.sent < session.out.size();
+        if (!pending) {
+            session.out.clear();
+            session.sent = 0;
+        }
+        // only wake on writability while something is left to send
+        if (pending != session.waiting) {
+            epoll_event ev{};
+            ev.events       = EPOLLIN | (pending ? uint32_t{EPOLLOUT} : 0u);
+            ev.data.fd      = session.fd;
+            session.waiting = pending;
+            ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, session.fd, &ev);
+        }
+    }
+};
+
+}  // namespace cgx::term::sim
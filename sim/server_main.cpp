@@ -0,0 +1,68 @@
+// Console server: one term_t session per client on a Unix-domain socket.
+//
+//   term_server [-c=<max sessions>] [-n=<tasks>] <socket>
+//
+// Connect with e.g. `socat -,raw,echo=0 UNIX-CONNECT:<socket>`.
+
+#include <csignal>
+#include <cstdio>
+
+#include "cli.hpp"
+#include "server.hpp"
+#include "workload.hpp"
+
+namespace {
+struct args_t {
+    const char* path{nullptr};
+    uint32_t    sessions{64};
+    uint32_t    tasks{0};
+};
+
+inline constexpr auto schema = cgx::term::arg::schema<args_t>(
+    "term_server",
+    cgx::term::arg::opt('c', "max concurrent sessions", &args_t::sessions),
+    cgx::term::arg::opt('n', "synthetic tasks to spawn", &args_t::tasks),
+    cgx::term::arg::pos("socket", "path to listen on", &args_t::path)
+);
+
+volatile std::sig_atomic_t running = 1;
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::array<char, 256> line;
+    cgx::term::sim::join_args(argc, argv, line);
+    args_t args{};
+    if (schema.parse(line.data(), args) != cgx::term::arg::status::ok ||
+        args.path == nullptr) {
+        std::fputs(cgx::term::arg::help<schema>.data(), stderr);
+        return 1;
+    }
+
+    cgx::sch::sim::workload_t workload{};
+    workload.tasks = args.tasks;
+    cgx::sch::sim::spawn(cgx::sch::scheduler, workload);
+    cgx::sch::scheduler.start();
+
+    const auto               cmds = cgx::term::sim::apps();
+    cgx::term::sim::server_t server{args.path, cmds, args.sessions};
+    if (!server.listen()) {
+        std::perror("term_server");
+        return 1;
+    }
+    std::signal(SIGINT, [](int) { running = 0; });
+    std::signal(SIGTERM, [](int) { running = 0; });
+
+    while (running) {
+        server.poll(1);
+    }
+
+    const auto& st = server.stats();
+    std::fprintf(
+        stderr, "sessions %zu/%zu, in %zu B, out %zu B in %zu writes, "
+        "dropped %zu B\n",
+        st.closed, st.accepted, st.bytes_in, st.bytes_out, st.writes,
+        st.dropped
+    );
+    cgx::sch::scheduler.stop();
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Benchmark for top and pkill against a large task table: spawns `-n` idle
+// tasks, then times `-r` top screens (render into the producer and flush to
+// the sink) and as many pkill scans over every task, finishing with one
+// pkill that kills them all.
+//
+//   top_bench [-n=<tasks>] [-r=<rounds>]
+//
+// Exits non-zero if a screen comes out without task rows.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "cli.hpp"
+#include "workload.hpp"
+
+namespace {
+struct args_t {
+    uint32_t tasks{3000};
+    uint32_t rounds{200};
+};
+
+inline constexpr auto schema = cgx::term::arg::schema<args_t>(
+    "top_bench",
+    cgx::term::arg::opt('n', "tasks to spawn", &args_t::tasks),
+    cgx::term::arg::opt('r', "screens and scans to time", &args_t::rounds)
+);
+
+using steady_t = std::chrono::steady_clock;
+
+uint32_t since_us(steady_t::time_point start) {
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            steady_t::now() - start
+        )
+            .count()
+    );
+}
+
+struct timings_t {
+    std::vector<uint32_t> us{};
+
+    void report(const char* what) {
+        std::sort(us.begin(), us.end());
+        uint64_t sum = 0;
+        for (const auto t : us) {
+            sum += t;
+        }
+        std::printf(
+            "  %-8s mean %6llu us, p50 %6u us, p99 %6u us, max %6u us\n", what,
+            static_cast<unsigned long long>(us.empty() ? 0 : sum / us.size()),
+            us.empty() ? 0u : us[us.size() / 2],
+            us.empty() ? 0u : us[(us.size() - 1) * 99 / 100],
+            us.empty() ? 0u : us.back()
+        );
+    }
+};
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::array<char, 256> line;
+    cgx::term::sim::join_args(argc, argv, line);
+    args_t args{};
+    if (schema.parse(line.data(), args) != cgx::term::arg::status::ok) {
+        std::fputs(cgx::term::arg::help<schema>.data(), stderr);
+        return 1;
+    }
+
+    // idle tasks, and the scheduler is driven by hand, so the timings are
+    // top's and pkill's own
+    cgx::sch::sim::workload_t workload{};
+    workload.tasks    = args.tasks;
+    workload.max_load = 0;
+    const auto spawned = cgx::sch::sim::spawn(cgx::sch::scheduler, workload);
+    cgx::sch::scheduler.run_once();
+
+    size_t             bytes = 0;
+    size_t             rows  = 0;
+    cgx::term::term_t term([&](const char* s) {
+        for (; *s != '\0'; s++) {
+            bytes++;
+            rows += *s == '\n' ? 1 : 0;
+        }
+    });
+    term.attach(cgx::term::apps::ns_top::out);
+
+    namespace ns_top = cgx::term::apps::ns_top;
+    timings_t render;
+    timings_t flush;
+    size_t    blank = 0;
+    for (uint32_t i = 0; i < args.rounds; i++) {
+        auto start = steady_t::now();
+        ns_top::stats_screen();
+        render.us.push_back(since_us(start));
+
+        const auto rows_before = rows;
+        start                  = steady_t::now();
+        term.flush();
+        flush.us.push_back(since_us(start));
+        // the title, a thread header and its column names come first
+        blank += rows - rows_before > 3 ? 0 : 1;
+    }
+    term.detach(ns_top::out);
+
+    namespace ns_pkill = cgx::term::apps::ns_pkill;
+    timings_t scan;
+    for (uint32_t i = 0; i < args.rounds; i++) {
+        const auto start = steady_t::now();
+        const auto ret   = ns_pkill::kill({"*nomatch*"}, true);
+        scan.us.push_back(since_us(start));
+        if (ret.count != 0) {
+            std::fputs("top_bench: pkill scan killed a task\n", stderr);
+            return 1;
+        }
+    }
+    const auto start  = steady_t::now();
+    const auto killed = ns_pkill::kill({"w*"}, true).count;
+    const auto kill   = since_us(start);
+
+    std::printf(
+        "%zu tasks, %u rounds\n"
+        "top: %.0f B and %.1f rows per screen, %zu blank\n",
+        spawned, args.rounds, double(bytes) / args.rounds,
+        double(rows) / args.rounds, blank
+    );
+    render.report("render");
+    flush.report("flush");
+    std::printf("pkill: glob over every task, nothing matching\n");
+    scan.report("scan");
+    std::printf("  kill -a  %zu tasks in %u us\n", killed, kill);
+    return blank == 0 && killed == spawned ? 0 : 1;
+}
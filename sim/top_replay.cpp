@@ -0,0 +1,172 @@
+// Reads a recording made with `top -b`. Without -r it prints, per task, a
+// summary of the rounds in the window; with -r it replays them row by row.
+// The window start is found with a binary search over the file's round
+// index, so only the rounds inside it are read.
+//
+//   top_replay [-s=<from>] [-d=<duration>] [-r] <file>
+//
+// -s and -d take durations (us, ms, s) relative to the oldest kept round.
+
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <string>
+
+#include "../apps/scheduler.hpp"
+#include "../apps/top/record.hpp"
+#include "cli.hpp"
+
+namespace {
+namespace record = cgx::term::apps::ns_top::record;
+
+struct args_t {
+    int64_t     from{0};
+    int64_t     duration{0};
+    bool        replay{false};
+    const char* file{nullptr};
+};
+
+inline constexpr auto schema = cgx::term::arg::schema<args_t>(
+    "top_replay",
+    cgx::term::arg::opt('s', "skip this long from the start", &args_t::from),
+    cgx::term::arg::opt(
+        'd', "only this long, to the end by default", &args_t::duration
+    ),
+    cgx::term::arg::opt('r', "print every row", &args_t::replay),
+    cgx::term::arg::pos("file", "recording made with top -b", &args_t::file)
+);
+
+struct summary_t {
+    uint64_t rounds{0};
+    uint64_t delayed{0};
+    int64_t  period{0};
+    int64_t  mean_sum{0};
+    int64_t  max{0};
+    int64_t  worst_actual{0};
+};
+
+void print_time(const char* label, int64_t time_us) {
+    const std::time_t t = time_us / 1'000'000;
+    char              buf[32];
+    std::strftime(buf, sizeof(buf), "%F %T", std::localtime(&t));
+    std::printf(
+        "%s%s.%03lld\n", label, buf,
+        static_cast<long long>(time_us % 1'000'000 / 1000)
+    );
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::array<char, 256> line;
+    cgx::term::sim::join_args(argc, argv, line);
+    args_t args{};
+    if (schema.parse(line.data(), args) != cgx::term::arg::status::ok ||
+        args.file == nullptr) {
+        std::fputs(cgx::term::arg::help<schema>.data(), stderr);
+        return 1;
+    }
+
+    record::reader_t reader;
+    if (!reader.open(args.file)) {
+        std::fprintf(
+            stderr, "top_replay: %s is not a top recording\n", args.file
+        );
+        return 1;
+    }
+    const auto first = reader.first_round();
+    const auto end   = reader.end_round();
+    if (first == end) {
+        std::printf("%s: no rounds recorded\n", args.file);
+        return 0;
+    }
+    const auto& hdr = reader.header();
+    std::printf(
+        "%s: %llu rounds kept of %llu, every %lld ms, %llu/%llu rows\n",
+        args.file, static_cast<unsigned long long>(end - first),
+        static_cast<unsigned long long>(end),
+        static_cast<long long>(hdr.period_us / 1000),
+        static_cast<unsigned long long>(
+            hdr.samples < hdr.sample_capacity ? hdr.samples
+                                              : hdr.sample_capacity
+        ),
+        static_cast<unsigned long long>(hdr.sample_capacity)
+    );
+    print_time("  oldest ", reader.round_time(first));
+    print_time("  newest ", reader.round_time(end - 1));
+
+    const auto start = reader.round_time(first) + args.from;
+    const auto stop  = args.duration > 0 ? start + args.duration
+                                         : reader.round_time(end - 1) + 1;
+    const auto from  = reader.seek(start);
+    if (from == record::npos) {
+        std::printf("no rounds after the requested start\n");
+        return 0;
+    }
+    print_time("  window ", reader.round_time(from));
+
+    std::map<std::string, summary_t> tasks;
+    uint64_t                         rounds = 0;
+    for (auto r = from; r < end && reader.round_time(r) < stop; r++) {
+        rounds++;
+        if (args.replay) {
+            std::printf(
+                "\n== round %llu +%.3fs\n", static_cast<unsigned long long>(r),
+                (reader.round_time(r) - reader.round_time(first)) / 1e6
+            );
+        }
+        reader.for_each(r, [&](const record::sample_t& row) {
+            if (args.replay) {
+                if (row.kind == record::kind_t::thread) {
+                    std::printf(
+                        "thread %u: %llu tasks, loop mean %lld min %lld "
+                        "max %lld us\n",
+                        row.thread, static_cast<unsigned long long>(row.tasks),
+                        static_cast<long long>(row.mean),
+                        static_cast<long long>(row.min),
+                        static_cast<long long>(row.max)
+                    );
+                } else {
+                    std::printf(
+                        "  %-15s %10lld %10lld %8lld %8lld %8lld\n", row.name,
+                        static_cast<long long>(row.period),
+                        static_cast<long long>(row.actual),
+                        static_cast<long long>(row.mean),
+                        static_cast<long long>(row.min),
+                        static_cast<long long>(row.max)
+                    );
+                }
+            }
+            if (row.kind != record::kind_t::task) {
+                return;
+            }
+            auto& s  = tasks[std::string(row.name, strnlen(row.name, 16))];
+            s.period = row.period;
+            s.rounds++;
+            s.mean_sum += row.mean;
+            s.max = row.max > s.max ? row.max : s.max;
+            s.worst_actual =
+                row.actual > s.worst_actual ? row.actual : s.worst_actual;
+            s.delayed +=
+                row.status ==
+                static_cast<uint8_t>(cgx::sch::task_t::status_t::delayed);
+        });
+    }
+
+    std::printf(
+        "\n%llu rounds\n%-15s %8s %10s %10s %10s %8s %8s\n",
+        static_cast<unsigned long long>(rounds), "task", "rounds", "every",
+        "actual_max", "mean_us", "max_us", "delayed"
+    );
+    for (const auto& [name, s] : tasks) {
+        std::printf(
+            "%-15s %8llu %10lld %10lld %10lld %8lld %8llu\n", name.c_str(),
+            static_cast<unsigned long long>(s.rounds),
+            static_cast<long long>(s.period),
+            static_cast<long long>(s.worst_actual),
+            static_cast<long long>(s.mean_sum / static_cast<int64_t>(s.rounds)),
+            static_cast<long long>(s.max),
+            static_cast<unsigned long long>(s.delayed)
+        );
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdio>
+#include <random>
+
+#include "../apps/scheduler.hpp"
+
+namespace cgx::sch::sim {
+
+// synthetic tasks with random periods and busy-wait loads
+struct workload_t {
+    size_t      tasks{1000};
+    time_t      min_period{1'000};    // us
+    time_t      max_period{100'000};  // us
+    time_t      min_load{0};          // us spent busy per run
+    time_t      max_load{20};         // us
+    uint32_t    seed{1};
+    const char* prefix{"w"};
+};
+
+// returns the number of tasks added
+inline size_t spawn(scheduler_t& scheduler, const workload_t& workload) {
+    std::minstd_rand                      rng{workload.seed};
+    std::uniform_int_distribution<time_t> period{
+        workload.min_period, workload.max_period
+    };
+    std::uniform_int_distribution<time_t> load{
+        workload.min_load, workload.max_load
+    };
+
+    size_t added = 0;
+    for (size_t i = 0; i < workload.tasks; i++) {
+        char name[16];
+        std::snprintf(
+            name, sizeof(name), "%s%05u", workload.prefix,
+            static_cast<unsigned>(i)
+        );
+        const auto busy = load(rng);
+        auto       fn   = [busy] {
+            const auto until = now_us() + busy;
+            while (now_us() < until) {
+            }
+            return true;
+        };
+        const auto thread = i % scheduler_t::max_threads;
+        if (scheduler.add({name, period(rng), fn}, thread)) {
+            added++;
+        }
+    }
+    return added;
+}
+
+}  // namespace cgx::sch::sim
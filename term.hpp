@@ -1,17 +1,135 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
 #include <cstdarg>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <functional>
+#include <limits>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace cgx::term {
 
 class term_t;
 
+// multiplier for an optional unit suffix: durations resolve to microseconds
+// (us, ms, s) and sizes to bytes (k, M). Returns 0 for an unknown suffix.
+inline uint64_t unit_scale(const char* s, const char* end) {
+    const auto len = static_cast<size_t>(end - s);
+    if (len == 0) {
+        return 1;
+    }
+    if (len == 2 && s[0] == 'u' && s[1] == 's') {
+        return 1;
+    }
+    if (len == 2 && s[0] == 'm' && s[1] == 's') {
+        return 1'000;
+    }
+    if (len == 1 && s[0] == 's') {
+        return 1'000'000;
+    }
+    if (len == 1 && s[0] == 'k') {
+        return 1024;
+    }
+    if (len == 1 && s[0] == 'M') {
+        return 1024 * 1024;
+    }
+    return 0;
+}
+
+// Strict, locale-independent conversion of [s, end). Integers accept 0x and
+// 0b prefixes, must fit in T after the unit suffix is applied, and any
+// trailing garbage makes the value invalid. A const char* takes `s` as is,
+// for values the caller reads itself; *end must be '\0'.
+template <typename T>
+bool parse_value(const char* s, const char* end, T& out) {
+    if constexpr (std::is_same_v<T, std::string>) {
+        out.assign(s, end);
+        return true;
+    } else if constexpr (std::is_same_v<T, const char*>) {
+        out = s;
+        return true;
+    } else if constexpr (std::is_integral_v<T>) {
+        const bool  neg  = s != end && *s == '-';
+        const char* p    = s + (neg ? 1 : 0);
+        int         base = 10;
+        if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+            base = 16;
+            p += 2;
+        } else if (end - p > 2 && p[0] == '0' &&
+                   (p[1] == 'b' || p[1] == 'B')) {
+            base = 2;
+            p += 2;
+        }
+        uint64_t   mag       = 0;
+        const auto [ptr, ec] = std::from_chars(p, end, mag, base);
+        if (ec != std::errc{} || ptr == p) {
+            return false;
+        }
+        const auto scale = unit_scale(ptr, end);
+        if (scale == 0 || __builtin_mul_overflow(mag, scale, &mag)) {
+            return false;
+        }
+        if constexpr (std::is_signed_v<T>) {
+            const uint64_t limit =
+                static_cast<uint64_t>(std::numeric_limits<T>::max()) +
+                (neg ? 1 : 0);
+            if (mag > limit) {
+                return false;
+            }
+            // negate in the unsigned domain so T's minimum does not overflow
+            out = static_cast<T>(neg ? ~mag + 1 : mag);
+        } else {
+            if (neg || mag > std::numeric_limits<T>::max()) {
+                return false;
+            }
+            out = static_cast<T>(mag);
+        }
+        return true;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        const auto [ptr, ec] =
+            std::from_chars(s, end, out, std::chars_format::general);
+        if (ec != std::errc{} || ptr == s) {
+            return false;
+        }
+        const auto scale = unit_scale(ptr, end);
+        if (scale == 0) {
+            return false;
+        }
+        out *= static_cast<T>(scale);
+        return true;
+    } else {
+        return false;
+    }
+}
+
+template <typename T>
+bool parse_value(const char* s, T& out) {
+    return parse_value(s, s + std::strlen(s), out);
+}
+
+template <typename T>
+T parse_value(const char* s) {
+    T value{};
+    parse_value(s, value);
+    return value;
+}
+
 class param_t {
    public:
     virtual char        id() const          = 0;
@@ -31,8 +149,17 @@ class param : public param_t {
         size_t i = 0;
         while (s[i + 1] != '\0') {
             if (s[i] == '-' && s[i + 1] == m_id && s[i + 2] == '=') {
-                m_valid = true;
-                return parse_value(s + i + 3);
+                const char* value = s + i + 3;
+                const char* end   = value + std::strlen(value);
+                if constexpr (!std::is_same_v<T, std::string>) {
+                    end = value;
+                    while (*end != '\0' && *end != ' ') {
+                        end++;
+                    }
+                }
+                T ret{};
+                m_valid = cgx::term::parse_value(value, end, ret);
+                return ret;
             }
             i++;
         }
@@ -41,33 +168,7 @@ class param : public param_t {
     }
 
     T parse_value(const char* s) {
-        if constexpr (std::is_same_v<T, int>) {
-            return std::atoi(s);
-        } else if constexpr (std::is_same_v<T, int8_t>) {
-            return std::atoi(s);
-        } else if constexpr (std::is_same_v<T, int16_t>) {
-            return std::atoi(s);
-        } else if constexpr (std::is_same_v<T, int32_t>) {
-            return std::atoi(s);
-        } else if constexpr (std::is_same_v<T, int64_t>) {
-            return std::atoll(s);
-        } else if constexpr (std::is_same_v<T, uint8_t>) {
-            return std::strtoul(s, nullptr, 10);
-        } else if constexpr (std::is_same_v<T, uint16_t>) {
-            return std::strtoul(s, nullptr, 10);
-        } else if constexpr (std::is_same_v<T, uint32_t>) {
-            return std::strtoul(s, nullptr, 10);
-        } else if constexpr (std::is_same_v<T, uint64_t>) {
-            return std::strtoull(s, nullptr, 10);
-        } else if constexpr (std::is_same_v<T, float>) {
-            return std::atof(s);
-        } else if constexpr (std::is_same_v<T, double>) {
-            return std::atof(s);
-        } else if constexpr (std::is_same_v<T, std::string>) {
-            return std::string(s);
-        } else {
-            return T{};
-        }
+        return cgx::term::parse_value<T>(s);
     }
 
     bool needs_input() const override {
@@ -343,6 +444,306 @@ class params : public param_t {
     }
 };
 
+namespace vt {
+enum state : uint8_t { ground, escape, csi_entry, ss3_entry, n_states };
+
+enum class action : uint8_t { none, emit, clear, param, next_param, csi, ss3 };
+
+enum byte_class : uint8_t {
+    ctl,  // C0 controls except ESC
+    esc,  // \x1b
+    lbr,  // '['
+    ss3,  // 'O'
+    dig,  // '0'-'9'
+    sep,  // ';'
+    fin,  // other 0x40-0x7e
+    mid,  // 0x20-0x2f, 0x3a-0x3f and UTF-8 bytes
+    del,  // 0x7f
+    n_classes,
+};
+
+constexpr uint8_t t(action a, state s) {
+    return static_cast<uint8_t>(static_cast<uint8_t>(a) << 4 | s);
+}
+
+constexpr std::array<uint8_t, 256> make_class_table() {
+    std::array<uint8_t, 256> table{};
+    for (size_t b = 0; b < table.size(); b++) {
+        if (b == 0x1b) {
+            table[b] = esc;
+        } else if (b < 0x20) {
+            table[b] = ctl;
+        } else if (b == '[') {
+            table[b] = lbr;
+        } else if (b == 'O') {
+            table[b] = ss3;
+        } else if (b >= '0' && b <= '9') {
+            table[b] = dig;
+        } else if (b == ';') {
+            table[b] = sep;
+        } else if (b == 0x7f) {
+            table[b] = del;
+        } else if (b >= 0x40 && b <= 0x7e) {
+            table[b] = fin;
+        } else {
+            table[b] = mid;
+        }
+    }
+    return table;
+}
+
+inline constexpr auto class_table = make_class_table();
+
+// high nibble: action, low nibble: next state.
+// controls abort any pending sequence so ctrl+c always gets through
+inline constexpr uint8_t transition_table[n_states][n_classes] = {
+    // ctl, esc, lbr, ss3, dig, sep, fin, mid, del
+    /* ground */
+    {t(action::emit, ground), t(action::none, escape), t(action::emit, ground),
+     t(action::emit, ground), t(action::emit, ground), t(action::emit, ground),
+     t(action::emit, ground), t(action::emit, ground), t(action::emit, ground)},
+    /* escape */
+    {t(action::emit, ground), t(action::none, escape),
+     t(action::clear, csi_entry), t(action::none, ss3_entry),
+     t(action::none, ground), t(action::none, ground), t(action::none, ground),
+     t(action::none, ground), t(action::none, ground)},
+    /* csi_entry */
+    {t(action::emit, ground), t(action::none, escape), t(action::csi, ground),
+     t(action::csi, ground), t(action::param, csi_entry),
+     t(action::next_param, csi_entry), t(action::csi, ground),
+     t(action::none, csi_entry), t(action::none, ground)},
+    /* ss3_entry */
+    {t(action::emit, ground), t(action::none, escape), t(action::ss3, ground),
+     t(action::ss3, ground), t(action::none, ss3_entry),
+     t(action::none, ss3_entry), t(action::ss3, ground),
+     t(action::none, ground), t(action::none, ground)},
+};
+}  // namespace vt
+
+// the portable byte-at-a-time find_control(), starting at `i`
+inline size_t find_control_scalar(const char* s, size_t n, size_t i = 0) {
+    for (; i < n; i++) {
+        const auto c = static_cast<uint8_t>(s[i]);
+        if (c < 0x20 || c == 0x7f) {
+            return i;
+        }
+    }
+    return n;
+}
+
+// returns the index of the first C0 control or DEL byte in `s`, or `n` if the
+// whole run is plain text that can be copied into the line as is.
+inline size_t find_control(const char* s, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const auto ctl = _mm_set1_epi8(0x1f);
+    const auto del = _mm_set1_epi8(0x7f);
+    for (; i + 16 <= n; i += 16) {
+        const auto v =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const auto hit = _mm_or_si128(
+            _mm_cmpeq_epi8(_mm_min_epu8(v, ctl), v), _mm_cmpeq_epi8(v, del)
+        );
+        const auto mask = _mm_movemask_epi8(hit);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const auto ctl = vdupq_n_u8(0x20);
+    const auto del = vdupq_n_u8(0x7f);
+    for (; i + 16 <= n; i += 16) {
+        const auto v   = vld1q_u8(reinterpret_cast<const uint8_t*>(s + i));
+        const auto hit = vorrq_u8(vcltq_u8(v, ctl), vceqq_u8(v, del));
+        if (vmaxvq_u8(hit) != 0) {
+            break;
+        }
+    }
+#endif
+    return find_control_scalar(s, n, i);
+}
+
+// Incremental VT/ANSI input decoder. Bytes are fed one at a time and the
+// state survives between calls, so sequences split across input() calls are
+// decoded the same way as whole ones.
+class vt_decoder_t {
+   public:
+    enum class key : uint8_t {
+        none,
+        character,  // printable byte or C0 control in `c`
+        up,
+        down,
+        right,
+        left,
+        home,
+        end,
+        insert,
+        del,
+        page_up,
+        page_down,
+        f1,
+        f2,
+        f3,
+        f4,
+        f5,
+        f6,
+        f7,
+        f8,
+        f9,
+        f10,
+        f11,
+        f12,
+        paste_begin,
+        paste_end,
+    };
+
+    struct event_t {
+        key  k{key::none};
+        char c{'\0'};
+    };
+
+    event_t feed(const char c) {
+        const auto b     = static_cast<uint8_t>(c);
+        const auto entry = vt::transition_table[m_state][vt::class_table[b]];
+        m_state          = static_cast<vt::state>(entry & 0x0f);
+        switch (static_cast<vt::action>(entry >> 4)) {
+            case vt::action::none:
+                return {};
+            case vt::action::emit:
+                return {key::character, c};
+            case vt::action::clear:
+                m_params.fill(0);
+                m_param_count = 0;
+                return {};
+            case vt::action::param:
+                if (m_param_count < m_params.size() &&
+                    m_params[m_param_count] < 1000) {
+                    m_params[m_param_count] =
+                        m_params[m_param_count] * 10 + (b - '0');
+                }
+                return {};
+            case vt::action::next_param:
+                if (m_param_count < m_params.size()) {
+                    m_param_count++;
+                }
+                return {};
+            case vt::action::csi:
+                return {csi_dispatch(c), '\0'};
+            case vt::action::ss3:
+                return {ss3_dispatch(c), '\0'};
+        }
+        return {};
+    }
+
+    void reset() {
+        m_state = vt::ground;
+    }
+
+    // true when no sequence is pending, so plain bytes map 1:1 to characters
+    bool idle() const {
+        return m_state == vt::ground;
+    }
+
+   private:
+    vt::state               m_state{vt::ground};
+    std::array<uint16_t, 2> m_params{};
+    size_t                  m_param_count{0};
+
+    key csi_dispatch(const char c) const {
+        switch (c) {
+            case 'A':
+                return key::up;
+            case 'B':
+                return key::down;
+            case 'C':
+                return key::right;
+            case 'D':
+                return key::left;
+            case 'H':
+                return key::home;
+            case 'F':
+                return key::end;
+            case '~':
+                break;
+            default:
+                return key::none;
+        }
+        switch (m_params[0]) {
+            case 1:
+            case 7:
+                return key::home;
+            case 2:
+                return key::insert;
+            case 3:
+                return key::del;
+            case 4:
+            case 8:
+                return key::end;
+            case 5:
+                return key::page_up;
+            case 6:
+                return key::page_down;
+            case 11:
+                return key::f1;
+            case 12:
+                return key::f2;
+            case 13:
+                return key::f3;
+            case 14:
+                return key::f4;
+            case 15:
+                return key::f5;
+            case 17:
+                return key::f6;
+            case 18:
+                return key::f7;
+            case 19:
+                return key::f8;
+            case 20:
+                return key::f9;
+            case 21:
+                return key::f10;
+            case 23:
+                return key::f11;
+            case 24:
+                return key::f12;
+            case 200:
+                return key::paste_begin;
+            case 201:
+                return key::paste_end;
+            default:
+                return key::none;
+        }
+    }
+
+    key ss3_dispatch(const char c) const {
+        switch (c) {
+            case 'A':
+                return key::up;
+            case 'B':
+                return key::down;
+            case 'C':
+                return key::right;
+            case 'D':
+                return key::left;
+            case 'H':
+                return key::home;
+            case 'F':
+                return key::end;
+            case 'P':
+                return key::f1;
+            case 'Q':
+                return key::f2;
+            case 'R':
+                return key::f3;
+            case 'S':
+                return key::f4;
+            default:
+                return key::none;
+        }
+    }
+};
+
 class cmd_t {
    public:
     enum class ret_code {
@@ -406,256 +807,1588 @@ class cmd_t {
     std::function<bool(term_t&, const char*)>     m_exit_fn{};
 };
 
-class term_t {
+// Static buffers owned by apps, reported by the mem command. Apps declare one
+// `static const footprint_t` next to each buffer; entries form an intrusive
+// list so registering them needs no allocation.
+class footprint_t {
    public:
-    term_t(std::function<void(const char*)> print) : m_print(print) {
+    footprint_t(const char* name, size_t bytes)
+        : m_name(name), m_bytes(bytes), m_next(s_head) {
+        s_head = this;
     }
 
-    void add(const cmd_t& cmd) {
-        m_cmds.push_back(cmd);
+    static const footprint_t* first() {
+        return s_head;
     }
-    void print(const char* s) const {
-        m_print(s);
+    const footprint_t* next() const {
+        return m_next;
+    }
+    const char* name() const {
+        return m_name;
+    }
+    size_t bytes() const {
+        return m_bytes;
     }
 
-    void printf(const char* fmt, ...) const {
-        char    buf[1024];
+   private:
+    const char*        m_name;
+    size_t             m_bytes;
+    const footprint_t* m_next;
+
+    inline static const footprint_t* s_head{nullptr};
+};
+
+// Output staging for code that prints from outside the terminal loop, e.g.
+// scheduler tasks. Each producer owns a single-producer/single-consumer ring:
+// the producer stages a message between begin() and commit() without locks,
+// and term_t::flush() -- the only writer to the sink -- emits every committed
+// message whole, so output from different producers never interleaves.
+class producer_t {
+   public:
+    struct stats_t {
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint32_t> messages{0};
+        std::atomic<uint32_t> dropped{0};
+        std::atomic<uint32_t> max_latency_us{0};
+        std::atomic<uint64_t> total_latency_us{0};
+        std::atomic<uint32_t> peak{0};  // most bytes ever staged in the ring
+    };
+
+    producer_t(const producer_t&)            = delete;
+    producer_t& operator=(const producer_t&) = delete;
+
+    // claims the producer for one message. Returns false if another thread is
+    // already writing one, so the caller can skip instead of blocking.
+    bool begin() {
+        if (m_busy.test_and_set(std::memory_order_acquire)) {
+            return false;
+        }
+        m_start    = m_tail.load(std::memory_order_relaxed);
+        m_write    = m_start + header_size;
+        m_overflow = m_write - m_head.load(std::memory_order_acquire) > m_size;
+        return true;
+    }
+
+    void print(const char* s) {
+        const size_t len = std::strlen(s);
+        if (m_overflow ||
+            m_write + len - m_head.load(std::memory_order_acquire) > m_size) {
+            m_overflow = true;
+            return;
+        }
+        copy_in(m_write, s, len);
+        m_write += len;
+    }
+
+    void printf(const char* fmt, ...) {
+        char    buf[256];
         va_list args;
         va_start(args, fmt);
         vsnprintf(buf, sizeof(buf), fmt, args);
         va_end(args);
-        m_print(buf);
+        print(buf);
     }
 
-    void enable_quick_cmd(bool enable) {
-        m_is_quick_cmd_enabled = enable;
+    // publishes the staged message. Returns false if it did not fit in the
+    // ring and was dropped.
+    bool commit() {
+        const bool ok = !m_overflow;
+        if (ok) {
+            const auto used = static_cast<uint32_t>(
+                m_write - m_head.load(std::memory_order_relaxed)
+            );
+            if (used > m_stats.peak.load(std::memory_order_relaxed)) {
+                m_stats.peak.store(used, std::memory_order_relaxed);
+            }
+            const uint32_t header[2] = {
+                static_cast<uint32_t>(m_write - m_start - header_size),
+                now_us(),
+            };
+            copy_in(
+                m_start, reinterpret_cast<const char*>(header), header_size
+            );
+            m_tail.store(m_write, std::memory_order_release);
+        } else {
+            m_stats.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_busy.clear(std::memory_order_release);
+        return ok;
     }
 
-    void run() {
-        process_buffer();
-        if (m_last_ret == cmd_t::ret_code::alive) {
-            // exit if ctrl+c
-            if (std::strncmp(m_line.data(), "\x03", m_line.size()) == 0) {
-                m_cmds[m_cmd_index].exit(*this, "");
-                m_last_ret = cmd_t::ret_code::killed;
-                print_error("\e[2KKilled by user");
-                reset_line();
-                return;
+    const char* name() const {
+        return m_name;
+    }
+    const stats_t& stats() const {
+        return m_stats;
+    }
+    size_t capacity() const {
+        return m_size;
+    }
+    // bytes a message can still take, header included. flush() frees more.
+    size_t available() const {
+        return m_size - (m_tail.load(std::memory_order_relaxed) -
+                         m_head.load(std::memory_order_acquire));
+    }
+
+    static uint32_t now_us() {
+        return static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            )
+                .count()
+        );
+    }
+
+   protected:
+    producer_t(const char* name, char* buffer, size_t size)
+        : m_name(name), m_buf(buffer), m_size(size) {
+    }
+
+   private:
+    friend class term_t;
+
+    static constexpr size_t header_size = 2 * sizeof(uint32_t);
+
+    const char* m_name;
+    char*       m_buf;
+    size_t      m_size;
+
+    std::atomic_flag    m_busy = ATOMIC_FLAG_INIT;
+    std::atomic<size_t> m_head{0};
+    std::atomic<size_t> m_tail{0};
+    size_t              m_start{0};
+    size_t              m_write{0};
+    bool                m_overflow{false};
+    stats_t             m_stats{};
+
+    void copy_in(size_t pos, const char* s, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            m_buf[(pos + i) % m_size] = s[i];
+        }
+    }
+    void copy_out(size_t pos, char* s, size_t len) const {
+        for (size_t i = 0; i < len; i++) {
+            s[i] = m_buf[(pos + i) % m_size];
+        }
+    }
+
+    // consumer side, only called by term_t::flush()
+    bool empty() const {
+        return m_head.load(std::memory_order_relaxed) ==
+               m_tail.load(std::memory_order_acquire);
+    }
+
+    template <typename F>
+    void drain(F&& print) {
+        size_t       head = m_head.load(std::memory_order_relaxed);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        while (head != tail) {
+            uint32_t header[2];
+            copy_out(head, reinterpret_cast<char*>(header), header_size);
+            size_t pos = head + header_size;
+            size_t len = header[0];
+            while (len > 0) {
+                char   chunk[129];
+                size_t n = len < sizeof(chunk) - 1 ? len : sizeof(chunk) - 1;
+                copy_out(pos, chunk, n);
+                chunk[n] = '\0';
+                print(chunk);
+                pos += n;
+                len -= n;
             }
-            m_last_ret = m_cmds[m_cmd_index].run(*this, m_line.data());
-            // if (m_is_line_valid) {
-            // m_last_ret = m_cmds[m_cmd_index].run(*this, "\n");
-            //}
-            if (m_last_ret != cmd_t::ret_code::alive) {
-                m_cmds[m_cmd_index].exit(*this, "");
-                if (m_last_ret == cmd_t::ret_code::error) {
-                    print_error("\e[2KExit with error");
-                }
-                reset_line();
-                return;
+            const uint32_t latency = now_us() - header[1];
+            m_stats.bytes.fetch_add(header[0], std::memory_order_relaxed);
+            m_stats.messages.fetch_add(1, std::memory_order_relaxed);
+            m_stats.total_latency_us.fetch_add(
+                latency, std::memory_order_relaxed
+            );
+            const auto max =
+                m_stats.max_latency_us.load(std::memory_order_relaxed);
+            if (latency > max) {
+                m_stats.max_latency_us.store(
+                    latency, std::memory_order_relaxed
+                );
             }
-            reset_line(false);
-            return;
+            head = pos;
+            m_head.store(head, std::memory_order_release);
         }
-        print_buffer();
+    }
+};
 
-        if (!m_is_line_valid) {
+// the ring of producer<N>. A base listed before producer_t, so the buffer is
+// constructed before producer_t takes its address.
+template <size_t N>
+struct producer_storage {
+    std::array<char, N> m_storage{};
+};
+
+template <size_t N>
+class producer : private producer_storage<N>, public producer_t {
+   public:
+    producer(const char* name)
+        : producer_storage<N>(), producer_t(name, this->m_storage.data(), N) {
+    }
+};
+
+// Command history packed back to back in one byte buffer. Entries are
+// NUL-terminated and never wrap, so each one is a plain C string and short
+// commands cost only their length. The oldest entries are evicted for room.
+template <size_t Bytes, size_t Entries>
+class history_t {
+    static_assert(Bytes <= std::numeric_limits<uint16_t>::max());
+
+   public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // lines that do not fit in the buffer are not kept
+    void push(const char* line, size_t len) {
+        if (len == 0 || len + 1 > Bytes) {
             return;
         }
-        if (std::strncmp(m_line.data(), "\x03", m_line.size()) == 0) {
-            reset_line();
-            return;
+        size_t pos = 0;
+        if (m_count > 0) {
+            const auto newest = start(0);
+            pos = newest + std::strlen(m_text.data() + newest) + 1;
         }
-        // split line by cmd name and arguments "cmd args"
-        auto args = std::strchr(m_line.data(), ' ');
-        if (args) {
-            *args = '\0';
-            args++;
+        if (pos + len + 1 > Bytes) {
+            // the entries past `pos` are the oldest; drop them and wrap
+            while (m_count > 0 && m_start[m_first] >= pos) {
+                drop_oldest();
+            }
+            pos = 0;
         }
-        auto len = std::strlen(m_line.data());
-        if (len == 0) {
-            reset_line();
-            return;
+        while (m_count > 0 &&
+               (m_count == Entries || overlaps(m_start[m_first], pos, len))) {
+            drop_oldest();
         }
-        size_t i = 0;
-        // printf("cmd: %s, args: %s\n", m_line.data(), args);
-        for (const auto& cmd : m_cmds) {
-            if (std::strncmp(cmd.cmd().data(), m_line.data(), len) == 0) {
-                m_print("\n");
-                m_cmd_index = i;
-                if (!cmd.init(*this, args)) {
-                    m_last_ret = cmd_t::ret_code::error;
-                    print_error("Error calling command");
-                    reset_line();
-                    return;
-                }
-                m_last_ret = cmd.run(*this, args);
-                if (m_last_ret != cmd_t::ret_code::alive) {
-                    m_cmds[m_cmd_index].exit(*this, args);
-                    if (m_last_ret == cmd_t::ret_code::error) {
-                        print_error("Exit with error");
-                    }
-                    reset_line();
-                }
-                return;
+        memcpy(m_text.data() + pos, line, len);
+        m_text[pos + len]                      = '\0';
+        m_start[(m_first + m_count) % Entries] = static_cast<uint16_t>(pos);
+        m_count++;
+    }
+
+    size_t size() const {
+        return m_count;
+    }
+
+    // i-th entry counting back from the newest (0)
+    const char* at(size_t i) const {
+        return m_text.data() + start(i);
+    }
+
+    // first entry from `from` back that contains `needle`, or npos
+    size_t find(std::string_view needle, size_t from) const {
+        for (size_t i = from; i < m_count; i++) {
+            if (std::string_view(at(i)).find(needle) != std::string_view::npos) {
+                return i;
             }
-            i++;
         }
-        m_print("\n");
-        print_error("Command not found: \"");
-        print_error(m_line.data());
-        print_error("\"");
-        reset_line();
+        return npos;
     }
 
-    const auto& commands() const {
-        return m_cmds;
+   private:
+    std::array<char, Bytes>       m_text{};
+    std::array<uint16_t, Entries> m_start{};
+    size_t                        m_first{0};
+    size_t                        m_count{0};
+
+    size_t start(size_t i) const {
+        return m_start[(m_first + m_count - 1 - i) % Entries];
     }
 
-    void input(const char input) {
-        m_input_buffer[m_input_tail] = input;
-        m_input_tail = (m_input_tail + 1) % m_input_buffer.size();
+    void drop_oldest() {
+        m_first = (m_first + 1) % Entries;
+        m_count--;
     }
 
-   private:
-    std::vector<cmd_t>     m_cmds{};
-    std::array<char, 1024> m_input_buffer{};
-    std::array<char, 1024> m_line{};
+    // whether the entry at `at` shares bytes with [pos, pos + len]
+    bool overlaps(size_t at, size_t pos, size_t len) const {
+        const auto end = at + std::strlen(m_text.data() + at) + 1;
+        return at <= pos + len && end > pos;
+    }
+};
 
-    static constexpr size_t               m_max_history = 10;
-    std::array<char[1024], m_max_history> m_last_line{};
-    size_t                                m_last_line_idx{0};
-    size_t                                m_last_line_head{0};
-    size_t                                m_last_line_tail{0};
+// A command started in the background with `cmd &`. The terminal loop steps
+// it when it is woken and keeps what it prints in its own buffer until it is
+// brought back with fg.
+class job_t {
+   public:
+    enum class state_t : uint8_t {
+        free,
+        running,
+        done,
+    };
 
-    std::function<void(const char*)> m_print{nullptr};
-    bool                             m_is_line_valid{false};
-    bool                             m_is_quick_cmd_enabled{false};
-    bool                             m_is_buffer_changed{false};
+    state_t state() const {
+        return m_state;
+    }
+    // index in the terminal's command table
+    size_t cmd() const {
+        return m_cmd;
+    }
+    const char* args() const {
+        return m_args.data();
+    }
+    // the first bytes printed since the job started or was last shown
+    const char* output() const {
+        return m_out.data();
+    }
+    size_t output_size() const {
+        return m_len;
+    }
+    // bytes printed after the buffer filled up
+    size_t dropped() const {
+        return m_dropped;
+    }
 
-    size_t m_input_head{0};
-    size_t m_input_tail{0};
+   private:
+    friend class term_t;
+
+    std::array<char, 64>  m_args{};
+    std::array<char, 512> m_out{};
+    size_t                m_len{0};
+    size_t                m_dropped{0};
+    size_t                m_cmd{0};
+    state_t               m_state{state_t::free};
+    // identifies this run of the slot to the driver that wakes it
+    std::atomic<uint32_t> m_token{0};
+    std::atomic<bool>     m_due{false};
+
+    void capture(const char* s) {
+        for (; *s != '\0'; s++) {
+            if (m_len < m_out.size() - 1) {
+                m_out[m_len++] = *s;
+            } else {
+                m_dropped++;
+            }
+        }
+        m_out[m_len] = '\0';
+    }
 
-    size_t m_line_index{0};
-    size_t m_line_last_printed_index{0};
+    void clear_output() {
+        m_len     = 0;
+        m_dropped = 0;
+        m_out[0]  = '\0';
+    }
+};
 
-    size_t          m_cmd_index{0};
-    cmd_t::ret_code m_last_ret{cmd_t::ret_code::ok};
+enum class log_level : uint8_t {
+    debug,
+    info,
+    warn,
+    error,
+    off,
+};
 
-    void process_buffer() {
-        if (m_is_line_valid) {
-            return;
+// Bounded multi-producer/single-consumer queue of log records. Producers only
+// copy the format string pointer and the raw arguments; formatting happens
+// later on the terminal thread. Format strings and string arguments must
+// outlive the record (string literals or static buffers).
+template <size_t N>
+class log_ring_t {
+   public:
+    static constexpr size_t max_args_size = 32;
+
+    struct record_t {
+        log_level   level{log_level::info};
+        const char* fmt{nullptr};
+        int (*format)(char*, size_t, const char*, const uint8_t*){nullptr};
+        std::array<uint8_t, max_args_size> args{};
+    };
+
+    log_ring_t() {
+        for (size_t i = 0; i < N; i++) {
+            m_slots[i].seq.store(i, std::memory_order_relaxed);
         }
+    }
+
+    template <typename... Args>
+    bool push(log_level level, const char* fmt, Args... args) {
+        static_assert(
+            (std::is_trivially_copyable_v<Args> && ...),
+            "log arguments must be trivially copyable"
+        );
+        static_assert(
+            (sizeof(Args) + ... + 0) <= max_args_size,
+            "too many log arguments"
+        );
+        size_t  pos = m_enqueue.load(std::memory_order_relaxed);
+        slot_t* slot;
+        while (true) {
+            slot           = &m_slots[pos % N];
+            const auto seq = slot->seq.load(std::memory_order_acquire);
+            const auto diff =
+                static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueue.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed
+                    )) {
+                    break;
+                }
+            } else if (diff < 0) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = m_enqueue.load(std::memory_order_relaxed);
+            }
+        }
+        slot->rec.level  = level;
+        slot->rec.fmt    = fmt;
+        slot->rec.format = &format<Args...>;
+        size_t offset    = 0;
+        ((std::memcpy(slot->rec.args.data() + offset, &args, sizeof(Args)),
+          offset += sizeof(Args)),
+         ...);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // single consumer
+    bool pop(record_t& rec) {
+        slot_t&    slot = m_slots[m_dequeue % N];
+        const auto seq  = slot.seq.load(std::memory_order_acquire);
+        if (seq != m_dequeue + 1) {
+            return false;
+        }
+        rec = slot.rec;
+        slot.seq.store(m_dequeue + N, std::memory_order_release);
+        m_dequeue++;
+        return true;
+    }
+
+    bool empty() const {
+        const auto& slot = m_slots[m_dequeue % N];
+        return slot.seq.load(std::memory_order_acquire) != m_dequeue + 1;
+    }
+
+    uint32_t dropped() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+   private:
+    struct slot_t {
+        std::atomic<size_t> seq{0};
+        record_t            rec{};
+    };
+
+    std::array<slot_t, N> m_slots{};
+    std::atomic<size_t>   m_enqueue{0};
+    size_t                m_dequeue{0};
+    std::atomic<uint32_t> m_dropped{0};
+
+    template <typename T>
+    static T load(const uint8_t* p) {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+
+    template <typename... Args, size_t... I>
+    static int format_impl(
+        char*          buf,
+        size_t         size,
+        const char*    fmt,
+        const uint8_t* args,
+        std::index_sequence<I...>
+    ) {
+        constexpr size_t sizes[] = {sizeof(Args)..., 0};
+        constexpr auto   offset  = [sizes](size_t i) {
+            size_t off = 0;
+            for (size_t j = 0; j < i; j++) {
+                off += sizes[j];
+            }
+            return off;
+        };
+        return std::snprintf(buf, size, fmt, load<Args>(args + offset(I))...);
+    }
+
+    template <typename... Args>
+    static int format(
+        char* buf, size_t size, const char* fmt, const uint8_t* args
+    ) {
+        if constexpr (sizeof...(Args) == 0) {
+            return std::snprintf(buf, size, "%s", fmt);
+        } else {
+            return format_impl<Args...>(
+                buf, size, fmt, args, std::index_sequence_for<Args...>{}
+            );
+        }
+    }
+};
+
+#if !defined(CGX_TERM_TRACE)
+#define CGX_TERM_TRACE 0
+#endif
+
+enum class trace_event : uint8_t {
+    ingest,    // process_buffer, arg: bytes taken from the input ring
+    flush,     // producer messages forwarded to the sink
+    log,       // log batch
+    cmd_init,  // arg: command index
+    cmd_run,   // arg: command index
+    cmd_exit,  // arg: command index
+    sink,      // one write to the print callback, arg: bytes
+};
+
+// Ring of timestamped spans on the terminal's hot path, enabled by building
+// with CGX_TERM_TRACE=1. When disabled every call is an empty inline no-op.
+template <bool Enabled, size_t N = 256>
+class tracer_t;
+
+template <size_t N>
+class tracer_t<false, N> {
+   public:
+    static constexpr bool enabled = false;
+
+    struct record_t {
+        uint32_t    ts;
+        uint32_t    dur;
+        uint16_t    arg;
+        trace_event ev;
+    };
+
+    struct span_t {
+        // user-provided so spans are not flagged as unused
+        ~span_t() {
+        }
+        void discard() {
+        }
+        uint16_t arg{0};
+    };
+
+    span_t span(trace_event, uint16_t arg = 0) {
+        return {arg};
+    }
+    void pause(bool) {
+    }
+    void clear() {
+    }
+    template <typename F>
+    void for_each(F&&) const {
+    }
+};
+
+template <size_t N>
+class tracer_t<true, N> {
+   public:
+    static constexpr bool enabled = true;
+
+    struct record_t {
+        uint32_t    ts;   // us, start of the span
+        uint32_t    dur;  // us
+        uint16_t    arg;
+        trace_event ev;
+    };
+
+    class span_t {
+       public:
+        span_t(tracer_t& tracer, trace_event ev, uint16_t arg)
+            : arg(arg), m_tracer(tracer), m_ev(ev), m_ts(now()) {
+        }
+        span_t(const span_t&)            = delete;
+        span_t& operator=(const span_t&) = delete;
+        ~span_t() {
+            if (m_keep) {
+                m_tracer.add({m_ts, now() - m_ts, arg, m_ev});
+            }
+        }
+
+        // drops the span, e.g. when it turned out to have nothing to do
+        void discard() {
+            m_keep = false;
+        }
+
+        uint16_t arg;
+
+       private:
+        tracer_t&   m_tracer;
+        trace_event m_ev;
+        bool        m_keep{true};
+        uint32_t    m_ts;
+    };
+
+    span_t span(trace_event ev, uint16_t arg = 0) {
+        return {*this, ev, arg};
+    }
+
+    // stops recording, e.g. while the ring itself is being dumped
+    void pause(bool paused) {
+        m_paused = paused;
+    }
+
+    void clear() {
+        m_next = 0;
+    }
+
+    // oldest to newest
+    template <typename F>
+    void for_each(F&& fn) const {
+        const size_t next  = m_next.load(std::memory_order_acquire);
+        const size_t count = next < N ? next : N;
+        for (size_t i = next - count; i < next; i++) {
+            fn(m_records[i % N]);
+        }
+    }
+
+   private:
+    std::array<record_t, N> m_records{};
+    std::atomic<size_t>     m_next{0};
+    bool                    m_paused{false};
+
+    static uint32_t now() {
+        return static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            )
+                .count()
+        );
+    }
+
+    void add(const record_t& record) {
+        if (m_paused) {
+            return;
+        }
+        const auto idx = m_next.fetch_add(1, std::memory_order_acq_rel);
+        m_records[idx % N] = record;
+    }
+};
+
+using trace_t = tracer_t<CGX_TERM_TRACE != 0>;
+
+class term_t {
+   public:
+    using cmds_t = std::vector<cmd_t>;
+
+    term_t(std::function<void(const char*)> print) : m_print(print) {
+    }
+    // a session running the commands of `cmds`, which must outlive it. Lets
+    // several terminals share one command table; their add() is then a no-op.
+    term_t(std::function<void(const char*)> print, const cmds_t& cmds)
+        : m_cmd_set(&cmds), m_print(print) {
+    }
+
+    void add(const cmd_t& cmd) {
+        if (m_cmd_set != &m_cmds) {
+            return;
+        }
+        m_cmds.push_back(cmd);
+    }
+    // also binds `cmd` to `key` for quick-command mode. Adds nothing and
+    // returns false if the key is reserved or taken, the command table is
+    // shared or already holds 255 commands.
+    bool add(const cmd_t& cmd, char key) {
+        const auto k = static_cast<uint8_t>(key);
+        if (m_cmd_set != &m_cmds || m_cmds.size() >= 255 ||
+            m_quick_cmds[k] != 0 || key == '\0' || key == '\r' ||
+            key == '\n' || key == '\x03' || key == '\e') {
+            return false;
+        }
+        m_cmds.push_back(cmd);
+        m_quick_cmds[k] = static_cast<uint8_t>(m_cmds.size());
+        return true;
+    }
+    void print(const char* s) const {
+        sink(s);
+    }
+
+    void printf(const char* fmt, ...) const {
+        char    buf[1024];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        sink(buf);
+    }
+
+    static constexpr size_t max_jobs = 4;
+
+    // called with a token when a job starts in the background. The driver
+    // calls wake_job(token) whenever the job should take a step, e.g. from a
+    // scheduler task, until it returns false. Without a hook jobs take a step
+    // on every run().
+    void set_job_hook(std::function<void(uint32_t token)> hook) {
+        m_job_hook = hook;
+    }
+
+    // safe to call from any thread. Returns false once the job is gone.
+    bool wake_job(uint32_t token) {
+        for (auto& job : m_jobs) {
+            if (job.m_token.load(std::memory_order_acquire) == token) {
+                job.m_due.store(true, std::memory_order_release);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // job `id` is jobs()[id - 1]
+    const auto& jobs() const {
+        return m_jobs;
+    }
+
+    // prints the output job `id` buffered. A running job then becomes the
+    // alive command once the calling command returns; a finished one is
+    // removed. Returns false if there is no such job.
+    bool foreground(size_t id) {
+        auto* job = find_job(id);
+        if (job == nullptr) {
+            return false;
+        }
+        show_job_output(*job);
+        if (job->m_state == job_t::state_t::running) {
+            m_fg_job = id;
+        } else {
+            free_job(*job);
+        }
+        return true;
+    }
+
+    // calls the exit hook of job `id` if it is still running and removes it
+    bool kill_job(size_t id) {
+        auto* job = find_job(id);
+        if (job == nullptr) {
+            return false;
+        }
+        if (job->m_state == job_t::state_t::running) {
+            job_call(*job, [&] {
+                (*m_cmd_set)[job->m_cmd].exit(*this, "");
+                return cmd_t::ret_code::killed;
+            });
+        }
+        free_job(*job);
+        return true;
+    }
+
+    // in quick-command mode a key bound with add(cmd, key) runs its command
+    // straight away, with no line editing, echo or name lookup. Other keys
+    // are dropped. Commands that stay alive get input as usual.
+    void enable_quick_cmd(bool enable) {
+        m_is_quick_cmd_enabled = enable;
+    }
+
+    // with plain runs off every input byte goes through the decoder, as it
+    // did before the fast path; for comparing the two
+    void enable_plain_runs(bool enable) {
+        m_is_plain_run_enabled = enable;
+    }
+
+    // registers a producer whose messages flush() forwards to the sink.
+    // One attached by a background job goes to the job's buffer instead,
+    // until the job is brought back with fg. Returns false if all slots are
+    // taken.
+    bool attach(producer_t& producer) {
+        for (size_t i = 0; i < m_producers.size(); i++) {
+            if (m_producers[i] == nullptr || m_producers[i] == &producer) {
+                m_producers[i]      = &producer;
+                m_producer_owner[i] = static_cast<uint8_t>(m_calling_job);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void detach(producer_t& producer) {
+        for (size_t i = 0; i < m_producers.size(); i++) {
+            if (m_producers[i] == &producer) {
+                m_producers[i]      = nullptr;
+                m_producer_owner[i] = 0;
+            }
+        }
+    }
+
+    // emits every committed producer message. Call only from the thread
+    // driving run(); it is the single writer to the sink.
+    void flush() {
+        for (size_t i = 0; i < m_producers.size(); i++) {
+            auto* p = m_producers[i];
+            if (p == nullptr || p->empty()) {
+                continue;
+            }
+            auto span = m_trace.span(trace_event::flush);
+            if (m_producer_owner[i] != 0) {
+                auto& job = m_jobs[m_producer_owner[i] - 1];
+                p->drain([&job](const char* s) { job.capture(s); });
+            } else {
+                p->drain([this](const char* s) { sink(s); });
+            }
+        }
+    }
+
+    trace_t& trace() {
+        return m_trace;
+    }
+
+    const auto& producers() const {
+        return m_producers;
+    }
+
+    // queues a record to be printed above the prompt by the terminal loop.
+    // Safe to call from any thread; returns false if filtered or dropped.
+    template <typename... Args>
+    bool log(log_level level, const char* fmt, Args... args) {
+        if (level < m_log_level.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        return m_log.push(level, fmt, args...);
+    }
+
+    void set_log_level(log_level level) {
+        m_log_level.store(level, std::memory_order_relaxed);
+    }
+    log_level get_log_level() const {
+        return m_log_level.load(std::memory_order_relaxed);
+    }
+    uint32_t log_dropped() const {
+        return m_log.dropped();
+    }
+
+    void run() {
+        if (m_interrupt.exchange(false, std::memory_order_acquire)) {
+            interrupt();
+        }
+        flush();
+        flush_log();
+        run_jobs();
+        if (m_is_quick_cmd_enabled && m_last_ret != cmd_t::ret_code::alive) {
+            quick_dispatch();
+            return;
+        }
+        {
+            const auto head = m_input_head;
+            auto       span = m_trace.span(trace_event::ingest);
+            process_buffer();
+            span.arg = static_cast<uint16_t>(
+                (m_input_head + m_input_buffer.size() - head) %
+                m_input_buffer.size()
+            );
+            // most passes find no input, keep the ring for the ones that did
+            if (span.arg == 0) {
+                span.discard();
+            }
+        }
+        if (m_last_ret == cmd_t::ret_code::alive) {
+            m_last_ret = cmd_run(m_line.data());
+            // if (m_is_line_valid) {
+            // m_last_ret = m_cmds[m_cmd_index].run(*this, "\n");
+            //}
+            if (m_last_ret != cmd_t::ret_code::alive) {
+                cmd_exit("");
+                if (m_last_ret == cmd_t::ret_code::error) {
+                    print_error("\e[2KExit with error");
+                }
+                reset_line();
+                return;
+            }
+            reset_line(false);
+            return;
+        }
+        print_buffer();
+
+        if (!m_is_line_valid) {
+            return;
+        }
+        // "cmd args &" runs in the background
+        bool background = false;
+        {
+            auto end = std::strlen(m_line.data());
+            while (end > 0 && m_line[end - 1] == ' ') {
+                end--;
+            }
+            if (end > 0 && m_line[end - 1] == '&') {
+                background = true;
+                end--;
+                while (end > 0 && m_line[end - 1] == ' ') {
+                    end--;
+                }
+                m_line[end] = '\0';
+            }
+        }
+        // split line by cmd name and arguments "cmd args"
+        auto args = std::strchr(m_line.data(), ' ');
+        if (args) {
+            *args = '\0';
+            args++;
+        }
+        auto len = std::strlen(m_line.data());
+        if (len == 0) {
+            reset_line();
+            return;
+        }
+        size_t i = 0;
+        // printf("cmd: %s, args: %s\n", m_line.data(), args);
+        for (const auto& cmd : *m_cmd_set) {
+            if (std::strncmp(cmd.cmd().data(), m_line.data(), len) == 0) {
+                sink("\n");
+                // commands keep their state in statics, two instances would
+                // share it
+                if (const auto id = running_job(i); id != 0) {
+                    char msg[48];
+                    std::snprintf(
+                        msg, sizeof(msg), "Already running as job [%u]",
+                        static_cast<unsigned>(id)
+                    );
+                    print_error(msg);
+                    reset_line();
+                    return;
+                }
+                if (background) {
+                    start_job(i, args);
+                    reset_line();
+                    return;
+                }
+                m_cmd_index = i;
+                if (!cmd_init(args)) {
+                    m_last_ret = cmd_t::ret_code::error;
+                    print_error("Error calling command");
+                    reset_line();
+                    return;
+                }
+                m_last_ret = cmd_run(args);
+                if (m_last_ret != cmd_t::ret_code::alive) {
+                    cmd_exit(args);
+                    if (m_last_ret == cmd_t::ret_code::error) {
+                        print_error("Exit with error");
+                    }
+                    if (resume_job()) {
+                        return;
+                    }
+                    reset_line();
+                }
+                return;
+            }
+            i++;
+        }
+        sink("\n");
+        print_error("Command not found: \"");
+        print_error(m_line.data());
+        print_error("\"");
+        reset_line();
+    }
+
+    const cmds_t& commands() const {
+        return *m_cmd_set;
+    }
+
+    // runs `cmd` once, from init to exit, with everything it prints sent to
+    // `output` instead of the terminal. Meant for commands that drive other
+    // commands (e.g. watch) while they hold the terminal as alive.
+    cmd_t::ret_code run_captured(
+        const cmd_t&                     cmd,
+        const char*                      args,
+        std::function<void(const char*)> output
+    ) {
+        std::swap(m_print, output);
+        auto ret = cmd_t::ret_code::error;
+        if (cmd.init(*this, args)) {
+            ret = cmd.run(*this, args);
+            cmd.exit(*this, args);
+        }
+        std::swap(m_print, output);
+        return ret;
+    }
+
+    void input(const char input) {
+        // Ctrl-C skips the ring so it cannot wait behind queued input or be
+        // overwritten by it; run() acts on it before anything else
+        if (input == '\x03') {
+            m_interrupt.store(true, std::memory_order_release);
+            return;
+        }
+        m_input_buffer[m_input_tail] = input;
+        m_input_tail = (m_input_tail + 1) % m_input_buffer.size();
+        const size_t used =
+            (m_input_tail + m_input_buffer.size() - m_input_head) %
+            m_input_buffer.size();
+        if (used > m_input_peak) {
+            m_input_peak = used;
+        }
+    }
+
+    struct memory_t {
+        size_t term;        // sizeof(term_t), wherever the instance lives
+        size_t input;       // input ring
+        size_t input_peak;  // most bytes ever waiting in the input ring
+        size_t line;        // line buffer
+        size_t history;     // history lines
+        size_t log;         // log ring
+        size_t cmds;        // registered commands
+        size_t cmds_heap;   // heap held by this terminal's own command table
+        size_t jobs;        // background job slots
+    };
+
+    // sizes fixed at compile time, e.g. for static_assert budgets
+    static constexpr memory_t static_memory() {
+        return {
+            sizeof(term_t),
+            sizeof(m_input_buffer),
+            0,
+            sizeof(m_line),
+            sizeof(m_history),
+            sizeof(m_log),
+            0,
+            0,
+            sizeof(m_jobs),
+        };
+    }
+
+    // std::function targets are not counted: captureless lambdas and function
+    // pointers fit in its inline storage and never allocate
+    memory_t memory() const {
+        auto mem       = static_memory();
+        mem.input_peak = m_input_peak;
+        mem.cmds       = m_cmd_set->size();
+        mem.cmds_heap  = m_cmds.capacity() * sizeof(cmd_t);
+        return mem;
+    }
+
+   private:
+    cmds_t                 m_cmds{};
+    const cmds_t*          m_cmd_set{&m_cmds};
+    std::array<char, 1024> m_input_buffer{};
+    std::array<char, 1024> m_line{};
+
+    // Ctrl-R incremental search. The query keeps the bytes past `len` so the
+    // line on screen can be compared with the next one and only the changed
+    // tail redrawn.
+    struct search_t {
+        bool                 active{false};
+        bool                 drawn{false};
+        bool                 failed{false};
+        std::array<char, 64> query{};
+        size_t               len{0};
+        size_t               match{0};  // history index, npos if none
+        size_t               drawn_len{0};
+        size_t               drawn_match{0};
+        bool                 drawn_failed{false};
+    };
+
+    // the search prompt as pieces, without copying them into one string
+    struct search_view_t {
+        std::array<std::string_view, 4> parts;
+
+        size_t size() const {
+            size_t n = 0;
+            for (const auto& p : parts) {
+                n += p.size();
+            }
+            return n;
+        }
+        char at(size_t i) const {
+            for (const auto& p : parts) {
+                if (i < p.size()) {
+                    return p[i];
+                }
+                i -= p.size();
+            }
+            return '\0';
+        }
+    };
+
+    history_t<4096, 128> m_history{};
+    size_t               m_last_line_idx{0};
+    search_t             m_search{};
+
+    std::function<void(const char*)> m_print{nullptr};
+    vt_decoder_t                     m_decoder{};
+    mutable trace_t                  m_trace{};
+    bool                             m_is_line_valid{false};
+    bool                             m_is_quick_cmd_enabled{false};
+    bool                             m_is_plain_run_enabled{true};
+    bool                             m_is_buffer_changed{false};
+
+    // key -> command index + 1, 0 when unbound
+    std::array<uint8_t, 256> m_quick_cmds{};
+
+    static constexpr size_t       m_max_log_records = 32;
+    log_ring_t<m_max_log_records> m_log{};
+    std::atomic<log_level>        m_log_level{log_level::info};
+
+    std::array<job_t, max_jobs>          m_jobs{};
+    std::function<void(uint32_t token)> m_job_hook{};
+    uint32_t                            m_job_serial{0};
+    size_t                              m_fg_job{0};  // id waiting for fg
+    size_t                              m_calling_job{0};  // in job_call()
+
+    static constexpr size_t                  m_max_producers = 8;
+    std::array<producer_t*, m_max_producers> m_producers{};
+    // id of the background job that attached each producer, 0 for none
+    std::array<uint8_t, m_max_producers> m_producer_owner{};
+
+    std::atomic<bool> m_interrupt{false};
+
+    size_t m_input_head{0};
+    size_t m_input_tail{0};
+    size_t m_input_peak{0};
+
+    size_t m_line_index{0};
+    size_t m_line_last_printed_index{0};
+
+    size_t          m_cmd_index{0};
+    cmd_t::ret_code m_last_ret{cmd_t::ret_code::ok};
+
+    void process_buffer() {
+        if (m_is_line_valid) {
+            return;
+        }
+        while (m_input_head != m_input_tail) {
+            if (ingest_plain_run()) {
+                continue;
+            }
+            const auto ev = m_decoder.feed(m_input_buffer[m_input_head]);
+            m_input_head = (m_input_head + 1) % m_input_buffer.size();
+            if (ev.k != vt_decoder_t::key::character) {
+                if (m_last_ret == cmd_t::ret_code::alive) {
+                    continue;
+                }
+                if (m_search.active) {
+                    search_end(true);
+                }
+                if (ev.k == vt_decoder_t::key::up) {
+                    history_prev();
+                } else if (ev.k == vt_decoder_t::key::down) {
+                    history_next();
+                }
+                continue;
+            }
+            const auto c = ev.c;
+            if (m_last_ret == cmd_t::ret_code::alive) {
+                m_line_index         = 0;
+                m_line[m_line_index] = c;
+                m_line_index         = (m_line_index + 1) % m_line.size();
+                m_line[m_line_index] = '\0';
+                m_is_line_valid      = true;
+                return;
+            }
+            if (c == '\x12' || m_search.active) {
+                if (search_key(c)) {
+                    continue;
+                }
+            }
+            if (c == '\b' || c == 127) {
+                if (m_line_index == 0) {
+                    continue;
+                }
+                m_line_index         = (m_line_index - 1) % m_line.size();
+                m_line[m_line_index] = '\0';
+                sink("\b \b");
+                m_line_last_printed_index = m_line_index;
+                continue;
+            }
+            if (c == '\n' || c == '\r') {
+                m_line[m_line_index] = '\0';
+                m_is_line_valid      = true;
+                m_history.push(m_line.data(), m_line_index);
+                m_last_line_idx = 0;
+                return;
+            }
+            m_line[m_line_index] = c;
+            m_line_index         = (m_line_index + 1) % m_line.size();
+            m_line[m_line_index] = '\0';
+            m_is_buffer_changed  = true;
+            // char buf[2] = {c, '\0'};
+            // sink(buf);
+        }
+    }
+
+    job_t* find_job(size_t id) {
+        if (id == 0 || id > m_jobs.size() ||
+            m_jobs[id - 1].m_state == job_t::state_t::free) {
+            return nullptr;
+        }
+        return &m_jobs[id - 1];
+    }
+
+    // the job running command `cmd`, 0 if there is none
+    size_t running_job(size_t cmd) const {
+        for (size_t i = 0; i < m_jobs.size(); i++) {
+            if (m_jobs[i].m_state == job_t::state_t::running &&
+                m_jobs[i].m_cmd == cmd) {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    // calls `fn` with everything printed going to the job's buffer, as do
+    // the messages of producers it attaches
+    template <typename F>
+    cmd_t::ret_code job_call(job_t& job, F&& fn) {
+        auto span = m_trace.span(trace_event::cmd_run, job.m_cmd);
+        std::function<void(const char*)> output = [&job](const char* s) {
+            job.capture(s);
+        };
+        const auto calling = m_calling_job;
+        m_calling_job = static_cast<size_t>(&job - m_jobs.data()) + 1;
+        std::swap(m_print, output);
+        const auto ret = fn();
+        std::swap(m_print, output);
+        m_calling_job = calling;
+        return ret;
+    }
+
+    // runs init and the first step in the background. A finished job only
+    // gives up its slot when no free one is left.
+    void start_job(size_t cmd, char* args) {
+        job_t* job = nullptr;
+        for (auto state : {job_t::state_t::free, job_t::state_t::done}) {
+            for (auto& j : m_jobs) {
+                if (job == nullptr && j.m_state == state) {
+                    job = &j;
+                }
+            }
+        }
+        if (job == nullptr) {
+            print_error("No free job slot");
+            return;
+        }
+        free_job(*job);
+        const auto  id = static_cast<size_t>(job - m_jobs.data()) + 1;
+        const auto& c  = (*m_cmd_set)[cmd];
+        job->m_cmd     = cmd;
+        job->m_state   = job_t::state_t::running;
+        if (args != nullptr) {
+            std::strncpy(job->m_args.data(), args, job->m_args.size() - 1);
+        }
+        printf(
+            "[%u] %s %s\n", static_cast<unsigned>(id), c.name(), job->args()
+        );
+
+        const auto ret = job_call(*job, [&] {
+            if (!c.init(*this, args)) {
+                return cmd_t::ret_code::error;
+            }
+            const auto r = c.run(*this, args);
+            if (r != cmd_t::ret_code::alive) {
+                c.exit(*this, args);
+            }
+            return r;
+        });
+        if (ret != cmd_t::ret_code::alive) {
+            finish_job(*job, ret);
+            return;
+        }
+        if (++m_job_serial == 0) {
+            ++m_job_serial;
+        }
+        job->m_token.store(m_job_serial, std::memory_order_release);
+        if (m_job_hook) {
+            m_job_hook(m_job_serial);
+        }
+    }
+
+    // one step of every running job that is due
+    void run_jobs() {
+        for (auto& job : m_jobs) {
+            if (job.m_state != job_t::state_t::running) {
+                continue;
+            }
+            if (m_job_hook &&
+                !job.m_due.exchange(false, std::memory_order_acq_rel)) {
+                continue;
+            }
+            const auto ret = job_call(job, [&] {
+                const auto& c = (*m_cmd_set)[job.m_cmd];
+                const auto  r = c.run(*this, "");
+                if (r != cmd_t::ret_code::alive) {
+                    c.exit(*this, "");
+                }
+                return r;
+            });
+            if (ret != cmd_t::ret_code::alive) {
+                finish_job(job, ret);
+            }
+        }
+    }
+
+    // keeps the output for fg and reports the job above the prompt
+    void finish_job(job_t& job, cmd_t::ret_code ret) {
+        const auto id = static_cast<unsigned>(&job - m_jobs.data()) + 1;
+        job.m_state   = job_t::state_t::done;
+        job.m_token.store(0, std::memory_order_release);
+        log(ret == cmd_t::ret_code::error ? log_level::error : log_level::info,
+            "[%u] done: %s (%u B of output)", id,
+            (*m_cmd_set)[job.m_cmd].name(),
+            static_cast<unsigned>(job.m_len + job.m_dropped));
+    }
+
+    // producers the job left attached, e.g. one brought back with fg, print
+    // to the terminal from now on
+    void free_job(job_t& job) {
+        const auto id = static_cast<size_t>(&job - m_jobs.data()) + 1;
+        for (auto& owner : m_producer_owner) {
+            if (owner == id) {
+                owner = 0;
+            }
+        }
+        job.m_token.store(0, std::memory_order_release);
+        job.m_due.store(false, std::memory_order_relaxed);
+        job.m_state = job_t::state_t::free;
+        job.m_args.fill('\0');
+        job.clear_output();
+    }
+
+    void show_job_output(job_t& job) {
+        sink(job.output());
+        if (job.m_dropped > 0) {
+            printf(
+                "\n[%u B of output dropped]\n",
+                static_cast<unsigned>(job.m_dropped)
+            );
+        }
+        job.clear_output();
+    }
+
+    // makes the job picked with fg the alive command
+    bool resume_job() {
+        if (m_fg_job == 0) {
+            return false;
+        }
+        auto& job = m_jobs[m_fg_job - 1];
+        m_fg_job  = 0;
+        if (job.m_state != job_t::state_t::running) {
+            return false;
+        }
+        m_cmd_index = job.m_cmd;
+        m_last_ret  = cmd_t::ret_code::alive;
+        free_job(job);
+        reset_line(false);
+        return true;
+    }
+
+    // Ctrl-C: kills the alive command, or drops the line being typed. Input
+    // still queued is dropped too, as a tty flushes it on an interrupt.
+    void interrupt() {
+        m_input_head = m_input_tail;
+        m_decoder.reset();
+        m_search.active = false;
+        if (m_last_ret == cmd_t::ret_code::alive) {
+            cmd_exit("");
+            m_last_ret = cmd_t::ret_code::killed;
+            print_error("\e[2KKilled by user");
+        }
+        reset_line();
+    }
+
+    // runs the command bound to the first bound key in the input. Keys go
+    // through the decoder so escape sequences do not fire their letters.
+    void quick_dispatch() {
         while (m_input_head != m_input_tail) {
-            const auto c = m_input_buffer[m_input_head];
-            m_input_head = (m_input_head + 1) % m_input_buffer.size();
-            // pass through ctrl+c
-            if (c == '\x03') {
-                m_line_index         = 0;
-                m_line[m_line_index] = c;
-                m_line_index         = (m_line_index + 1) % m_line.size();
-                m_line[m_line_index] = '\0';
-                m_is_line_valid      = true;
-                return;
+            const auto ev = m_decoder.feed(m_input_buffer[m_input_head]);
+            m_input_head  = (m_input_head + 1) % m_input_buffer.size();
+            if (ev.k != vt_decoder_t::key::character) {
+                continue;
             }
-            if (m_last_ret == cmd_t::ret_code::alive) {
-                m_line_index         = 0;
-                m_line[m_line_index] = c;
-                m_line_index         = (m_line_index + 1) % m_line.size();
-                m_line[m_line_index] = '\0';
-                m_is_line_valid      = true;
+            const auto idx = m_quick_cmds[static_cast<uint8_t>(ev.c)];
+            if (idx == 0) {
+                continue;
+            }
+            m_cmd_index = idx - 1;
+            if (!cmd_init(nullptr)) {
+                m_last_ret = cmd_t::ret_code::error;
+                print_error("Error calling command");
                 return;
             }
-            // if arrow
-            if (c == '\x1b') {
-                if (m_input_head == m_input_tail) {
-                    continue;
-                }
-                const auto c1 = m_input_buffer[m_input_head];
-                m_input_head  = (m_input_head + 1) % m_input_buffer.size();
-                const auto c2 = m_input_buffer[m_input_head];
-                m_input_head  = (m_input_head + 1) % m_input_buffer.size();
-                if (c1 == '[' && c2 == 'A') {
-                    // arrow up
-                    // reset_line();
-                    if (m_last_line_idx >= get_history_size()) {
-                        continue;
-                    }
-                    m_print("\r\e[2K> ");
-                    m_last_line_idx++;
-                    auto line = m_last_line
-                        [(m_last_line_head + get_history_size() -
-                          m_last_line_idx) %
-                         m_max_history];
-                    m_line_index = strlen(line);
-                    if (m_line_index > 0) {
-                        memcpy(m_line.data(), line, m_line_index + 1);
-                        m_print(line);
-                    }
-                    continue;
-                }
-                if (c1 == '[' && c2 == 'B') {
-                    // arrow down
-                    if (m_last_line_idx <= 0) {
-                        continue;
-                    }
-                    m_last_line_idx--;
-                    m_print("\r\e[2K> ");
-                    if (m_last_line_idx == 0) {
-                        m_line_index         = 0;
-                        m_line[m_line_index] = '\0';
-                        continue;
-                    }
-                    auto line = m_last_line
-                        [(m_last_line_head + get_history_size() -
-                          m_last_line_idx) %
-                         m_max_history];
-                    m_line_index = strlen(line);
-                    if (m_line_index > 0) {
-                        memcpy(m_line.data(), line, m_line_index + 1);
-                        m_print(line);
-                    }
-                    continue;
+            m_last_ret = cmd_run(nullptr);
+            if (m_last_ret != cmd_t::ret_code::alive) {
+                cmd_exit(nullptr);
+                if (m_last_ret == cmd_t::ret_code::error) {
+                    print_error("Exit with error");
                 }
-                continue;
             }
+            return;
+        }
+    }
 
-            if (c == '\b' || c == 127) {
-                if (m_line_index == 0) {
-                    continue;
-                }
-                m_line_index         = (m_line_index - 1) % m_line.size();
-                m_line[m_line_index] = '\0';
-                m_print("\b \b");
-                m_line_last_printed_index = m_line_index;
-                continue;
+    // copies the run of plain bytes at the head of the input ring into the
+    // line in one step. Returns false if the next byte needs the decoder.
+    bool ingest_plain_run() {
+        if (!m_is_plain_run_enabled || m_last_ret == cmd_t::ret_code::alive ||
+            !m_decoder.idle() || m_search.active) {
+            return false;
+        }
+        const size_t end = m_input_tail > m_input_head ? m_input_tail
+                                                       : m_input_buffer.size();
+        size_t n = find_control(
+            m_input_buffer.data() + m_input_head, end - m_input_head
+        );
+        const size_t room = m_line.size() - 1 - m_line_index;
+        if (n > room) {
+            n = room;
+        }
+        if (n == 0) {
+            return false;
+        }
+        memcpy(m_line.data() + m_line_index,
+               m_input_buffer.data() + m_input_head, n);
+        m_line_index += n;
+        m_line[m_line_index] = '\0';
+        m_is_buffer_changed  = true;
+        m_input_head += n;
+        if (m_input_head == m_input_buffer.size()) {
+            m_input_head = 0;
+        }
+        return true;
+    }
+
+    void history_prev() {
+        if (m_last_line_idx >= m_history.size()) {
+            return;
+        }
+        sink("\r\e[2K> ");
+        m_last_line_idx++;
+        load_history_line();
+    }
+
+    void history_next() {
+        if (m_last_line_idx <= 0) {
+            return;
+        }
+        m_last_line_idx--;
+        sink("\r\e[2K> ");
+        if (m_last_line_idx == 0) {
+            m_line_index              = 0;
+            m_line[m_line_index]      = '\0';
+            m_line_last_printed_index = 0;
+            m_is_buffer_changed       = false;
+            return;
+        }
+        load_history_line();
+    }
+
+    void load_history_line() {
+        load_line(m_history.at(m_last_line_idx - 1));
+        sink(m_line.data());
+    }
+
+    // the caller echoes the new line, print_buffer() must not echo it again
+    void load_line(const char* line) {
+        m_line_index = strlen(line);
+        if (m_line_index > m_line.size() - 1) {
+            m_line_index = m_line.size() - 1;
+        }
+        memcpy(m_line.data(), line, m_line_index);
+        m_line[m_line_index]      = '\0';
+        m_line_last_printed_index = m_line_index;
+        m_is_buffer_changed       = false;
+    }
+
+    // handles a byte typed while searching, or the Ctrl-R that starts a
+    // search. Returns false if the byte should go on to the line editor.
+    bool search_key(char c) {
+        auto& q = m_search;
+        if (!q.active) {
+            q        = {};
+            q.active = true;
+            q.match  = decltype(m_history)::npos;
+            search_draw();
+            return true;
+        }
+        if (c == '\x12') {
+            if (q.len > 0 && q.match != decltype(m_history)::npos) {
+                search_update(q.match + 1);
             }
-            if (c == '\n' || c == '\r') {
-                m_line[m_line_index] = '\0';
-                m_is_line_valid      = true;
-                if (m_line_index > 0) {
-                    if (m_last_line_head ==
-                        (m_last_line_tail + 1) % m_max_history) {
-                        m_last_line_head =
-                            (m_last_line_head + 1) % m_max_history;
-                    }
-                    memcpy(
-                        m_last_line[m_last_line_tail],
-                        m_line.data(),
-                        m_line_index + 1
-                    );
-                    m_last_line_tail = (m_last_line_tail + 1) % m_max_history;
-                }
-                m_last_line_idx = 0;
-                return;
+        } else if (c == '\b' || c == 127) {
+            if (q.len > 0) {
+                q.len--;
+            }
+            search_update(0);
+        } else if (c == '\a') {  // Ctrl-G: back to the line as it was
+            search_end(false);
+        } else if (c == '\n' || c == '\r') {
+            search_end(true);
+            return false;
+        } else if (static_cast<unsigned char>(c) >= ' ') {
+            if (q.len < q.query.size()) {
+                q.query[q.len++] = c;
+            }
+            search_update(q.match == decltype(m_history)::npos ? 0 : q.match);
+        } else {
+            search_end(true);
+            return false;
+        }
+        return true;
+    }
+
+    // searches from history index `from` back and redraws
+    void search_update(size_t from) {
+        auto& q = m_search;
+        if (q.len == 0) {
+            q.match  = decltype(m_history)::npos;
+            q.failed = false;
+        } else {
+            const auto i =
+                m_history.find(std::string_view(q.query.data(), q.len), from);
+            q.failed = i == decltype(m_history)::npos;
+            if (!q.failed) {
+                q.match = i;
             }
-            m_line[m_line_index] = c;
-            m_line_index         = (m_line_index + 1) % m_line.size();
-            m_line[m_line_index] = '\0';
-            m_is_buffer_changed  = true;
-            // char buf[2] = {c, '\0'};
-            // m_print(buf);
         }
+        search_draw();
+    }
+
+    search_view_t search_view(size_t len, size_t match, bool failed) const {
+        return {{
+            failed ? "(failed reverse-i-search)'" : "(reverse-i-search)'",
+            std::string_view(m_search.query.data(), len),
+            "': ",
+            match == decltype(m_history)::npos ? "" : m_history.at(match),
+        }};
+    }
+
+    // rewrites the search prompt from the first column that differs from
+    // what is on screen
+    void search_draw() {
+        auto&      q    = m_search;
+        const auto next = search_view(q.len, q.match, q.failed);
+        size_t     from = 0;
+        if (!q.drawn) {
+            sink("\r\e[2K");
+        } else {
+            const auto prev =
+                search_view(q.drawn_len, q.drawn_match, q.drawn_failed);
+            const auto n =
+                prev.size() < next.size() ? prev.size() : next.size();
+            while (from < n && prev.at(from) == next.at(from)) {
+                from++;
+            }
+            if (prev.size() > from) {
+                // room for any size_t count
+                char move[32];
+                snprintf(move, sizeof(move), "\e[%zuD\e[K", prev.size() - from);
+                sink(move);
+            }
+        }
+        char   buf[128];
+        size_t len = 0;
+        for (size_t i = from; i < next.size(); i++) {
+            buf[len++] = next.at(i);
+            if (len == sizeof(buf) - 1) {
+                buf[len] = '\0';
+                sink(buf);
+                len = 0;
+            }
+        }
+        buf[len] = '\0';
+        sink(buf);
+        q.drawn        = true;
+        q.drawn_len    = q.len;
+        q.drawn_match  = q.match;
+        q.drawn_failed = q.failed;
+    }
+
+    // leaves search mode with the match on the line, or with the line as it
+    // was before the search
+    void search_end(bool accept) {
+        auto& q  = m_search;
+        q.active = false;
+        if (accept && q.match != decltype(m_history)::npos) {
+            load_line(m_history.at(q.match));
+        }
+        m_last_line_idx = 0;
+        sink("\r\e[2K> ");
+        sink(m_line.data());
+        m_line_last_printed_index = m_line_index;
+        m_is_buffer_changed       = false;
     }
 
     void print_buffer() {
@@ -671,31 +2404,114 @@ class term_t {
             m_line_last_printed_index = 0;
         }
         m_line[m_line_index] = '\0';
-        m_print(m_line.data() + m_line_last_printed_index);
+        sink(m_line.data() + m_line_last_printed_index);
+        m_line_last_printed_index = m_line_index;
+    }
+
+    // prints every queued log record in one sink write, erasing the prompt
+    // before the batch and redrawing it, with the partial line, after it.
+    // Records wait while an alive command owns the screen.
+    void flush_log() {
+        if (m_last_ret == cmd_t::ret_code::alive || m_log.empty()) {
+            return;
+        }
+        auto span = m_trace.span(trace_event::log);
+        static constexpr const char* tags[] = {
+            "\e[90m[D]\e[0m ",
+            "[I] ",
+            "\e[33m[W]\e[0m ",
+            "\e[31m[E]\e[0m ",
+        };
+        std::array<char, 1024> batch;
+        size_t                 len = 0;
+
+        auto append = [&](const char* s, size_t n) {
+            while (n > 0) {
+                if (len == batch.size() - 1) {
+                    batch[len] = '\0';
+                    sink(batch.data());
+                    len = 0;
+                }
+                size_t room = batch.size() - 1 - len;
+                size_t k    = n < room ? n : room;
+                memcpy(batch.data() + len, s, k);
+                len += k;
+                s += k;
+                n -= k;
+            }
+        };
+        append("\r\e[2K", 5);
+        typename decltype(m_log)::record_t rec;
+        while (m_log.pop(rec)) {
+            const auto tag = tags[static_cast<size_t>(rec.level) % 4];
+            append(tag, std::strlen(tag));
+            char buf[256];
+            int  n = rec.format(buf, sizeof(buf), rec.fmt, rec.args.data());
+            if (n < 0) {
+                n = 0;
+            }
+            if (static_cast<size_t>(n) >= sizeof(buf)) {
+                n = sizeof(buf) - 1;
+            }
+            append(buf, n);
+            append("\n", 1);
+        }
+        if (m_search.active) {
+            // the records scrolled the search prompt away, draw it whole
+            batch[len] = '\0';
+            sink(batch.data());
+            m_search.drawn = false;
+            search_draw();
+            return;
+        }
+        append("> ", 2);
+        append(m_line.data(), m_line_index);
+        batch[len] = '\0';
+        sink(batch.data());
         m_line_last_printed_index = m_line_index;
     }
 
+    bool cmd_init(const char* args) {
+        auto span = m_trace.span(trace_event::cmd_init, m_cmd_index);
+        return (*m_cmd_set)[m_cmd_index].init(*this, args);
+    }
+
+    cmd_t::ret_code cmd_run(const char* args) {
+        auto span = m_trace.span(trace_event::cmd_run, m_cmd_index);
+        return (*m_cmd_set)[m_cmd_index].run(*this, args);
+    }
+
+    bool cmd_exit(const char* args) {
+        auto span = m_trace.span(trace_event::cmd_exit, m_cmd_index);
+        return (*m_cmd_set)[m_cmd_index].exit(*this, args);
+    }
+
+    // every write to the print callback goes through here
+    void sink(const char* s) const {
+        if constexpr (trace_t::enabled) {
+            auto span = m_trace.span(
+                trace_event::sink, static_cast<uint16_t>(std::strlen(s))
+            );
+            m_print(s);
+        } else {
+            m_print(s);
+        }
+    }
+
     void reset_line(bool prompt = true) {
-        m_line_index = 0;
+        m_line_index              = 0;
+        m_line_last_printed_index = 0;
         m_line.fill('\0');
         m_is_line_valid = false;
         if (prompt) {
-            m_print("\n\e[2K> ");
+            sink("\n\e[2K> ");
         }
     }
 
     void print_error(const char* s) const {
-        m_print("\e[31m");
-        m_print(s);
-        m_print("\e[0m");
-    }
-
-   private:
-    size_t get_history_size() const {
-        if (m_last_line_head <= m_last_line_tail) {
-            return m_last_line_tail - m_last_line_head;
-        }
-        return m_max_history - m_last_line_head + m_last_line_tail;
+        sink("\e[31m");
+        sink(s);
+        sink("\e[0m");
     }
 };
 
@@ -780,4 +2596,367 @@ inline bool param_help(
     return true;
 }
 
+// Declarative argument schema. Flags and positionals are declared once as a
+// constexpr object, parsed into a plain struct in a single pass, and the
+// usage/help text is rendered at compile time into read-only memory.
+//
+//   struct args_t {
+//       bool                         all{false};
+//       std::array<const char*, 8>   names{};
+//   };
+//   inline constexpr auto schema = arg::schema<args_t>(
+//       "pkill",
+//       arg::opt('a', "kill all", &args_t::all),
+//       arg::pos("names", "names or globs", &args_t::names)
+//   );
+//   ...
+//   args_t      a{};
+//   arg::line_t line;
+//   switch (schema.parse(args, a, line)) { ... }
+//   term.print(arg::help<schema>.data());
+namespace arg {
+
+enum class status {
+    ok,
+    help,
+    error,
+};
+
+// a command's arguments, copied to be tokenized; the parsed struct points
+// into it
+using line_t = std::array<char, 256>;
+
+template <typename S, typename T>
+struct opt_t {
+    char        id;
+    const char* description;
+    T S::*      member;
+};
+
+// single token (const char*) or a list of tokens (std::array<const char*, N>)
+template <typename S, typename T>
+struct pos_t {
+    const char* name;
+    const char* description;
+    T S::*      member;
+};
+
+// everything left on the line, untokenized
+template <typename S>
+struct rest_t {
+    const char*       name;
+    const char*       description;
+    const char* S::*member;
+};
+
+template <typename S, typename T>
+constexpr opt_t<S, T> opt(char id, const char* description, T S::*member) {
+    return {id, description, member};
+}
+
+template <typename S, typename T>
+constexpr pos_t<S, T> pos(
+    const char* name, const char* description, T S::*member
+) {
+    return {name, description, member};
+}
+
+template <typename S>
+constexpr rest_t<S> rest(
+    const char* name, const char* description, const char* S::*member
+) {
+    return {name, description, member};
+}
+
+namespace detail {
+template <typename T>
+struct slots {
+    static constexpr size_t value = 1;
+};
+template <size_t N>
+struct slots<std::array<const char*, N>> {
+    static constexpr size_t value = N;
+};
+
+struct counter_t {
+    size_t len{0};
+
+    constexpr void put(char) {
+        len++;
+    }
+    constexpr void put(const char* s) {
+        while (*s != '\0') {
+            put(*s++);
+        }
+    }
+};
+
+template <size_t N>
+struct writer_t {
+    std::array<char, N> buf{};
+    size_t              len{0};
+
+    constexpr void put(char c) {
+        if (len + 1 < N) {
+            buf[len++] = c;
+        }
+    }
+    constexpr void put(const char* s) {
+        while (*s != '\0') {
+            put(*s++);
+        }
+    }
+};
+
+constexpr size_t length(const char* s) {
+    size_t len = 0;
+    while (s[len] != '\0') {
+        len++;
+    }
+    return len;
+}
+
+inline char* skip_spaces(char* s) {
+    while (*s == ' ') {
+        s++;
+    }
+    return s;
+}
+
+// terminates the token starting at `s` and returns the start of the next one
+inline char* cut_token(char* s) {
+    while (*s != '\0' && *s != ' ') {
+        s++;
+    }
+    if (*s == ' ') {
+        *s++ = '\0';
+    }
+    return s;
+}
+
+inline bool is_flag(const char* s) {
+    const bool alpha =
+        (s[1] >= 'a' && s[1] <= 'z') || (s[1] >= 'A' && s[1] <= 'Z');
+    return s[0] == '-' && alpha &&
+           (s[2] == '\0' || s[2] == ' ' || s[2] == '=');
+}
+}  // namespace detail
+
+template <typename S, typename... F>
+class schema_t {
+   public:
+    constexpr schema_t(const char* cmd, F... fields)
+        : m_cmd(cmd), m_fields(fields...) {
+    }
+
+    // arguments a command was called with are not its to write, they are
+    // copied to `line` first. Too long for it is an error.
+    template <size_t N>
+    status parse(const char* s, S& out, std::array<char, N>& line) const {
+        if (s == nullptr) {
+            return status::ok;
+        }
+        const size_t len = std::strlen(s);
+        if (len >= N) {
+            return status::error;
+        }
+        std::memcpy(line.data(), s, len + 1);
+        return parse(line.data(), out);
+    }
+
+    // tokens are terminated in place
+    status parse(char* s, S& out) const {
+        if (s == nullptr) {
+            return status::ok;
+        }
+        char*  p     = detail::skip_spaces(s);
+        size_t index = 0;
+        while (*p != '\0') {
+            if (detail::is_flag(p)) {
+                const char  id    = p[1];
+                const char* value = p[2] == '=' ? p + 3 : nullptr;
+                p                 = detail::skip_spaces(detail::cut_token(p));
+                bool found        = false;
+                bool valid        = true;
+                std::apply(
+                    [&](const auto&... f) {
+                        (set_opt(f, id, value, out, found, valid), ...);
+                    },
+                    m_fields
+                );
+                if (!found) {
+                    return id == 'h' ? status::help : status::error;
+                }
+                if (!valid) {
+                    return status::error;
+                }
+                continue;
+            }
+            bool   taken = false;
+            bool   done  = false;
+            size_t base  = 0;
+            char*  next  = p;
+            std::apply(
+                [&](const auto&... f) {
+                    (set_pos(f, index, base, p, next, out, taken, done), ...);
+                },
+                m_fields
+            );
+            if (!taken) {
+                return status::error;
+            }
+            if (done) {
+                break;
+            }
+            index++;
+            p = detail::skip_spaces(next);
+        }
+        return status::ok;
+    }
+
+    template <typename W>
+    constexpr void render(W& w) const {
+        w.put("Usage: ");
+        w.put(m_cmd);
+        std::apply([&](const auto&... f) { (usage(w, f), ...); }, m_fields);
+        w.put('\n');
+        std::apply([&](const auto&... f) { (help(w, f), ...); }, m_fields);
+    }
+
+    constexpr size_t text_size() const {
+        detail::counter_t c{};
+        render(c);
+        return c.len + 1;
+    }
+
+    template <size_t N>
+    constexpr std::array<char, N> text() const {
+        detail::writer_t<N> w{};
+        render(w);
+        return w.buf;
+    }
+
+   private:
+    const char*      m_cmd;
+    std::tuple<F...> m_fields;
+
+    template <typename T>
+    static void set_opt(
+        const opt_t<S, T>& f,
+        char               id,
+        const char*        value,
+        S&                 out,
+        bool&              found,
+        bool&              valid
+    ) {
+        if (found || f.id != id) {
+            return;
+        }
+        found = true;
+        if constexpr (std::is_same_v<T, bool>) {
+            out.*f.member = true;
+        } else {
+            if (value == nullptr) {
+                valid = false;
+                return;
+            }
+            valid = parse_value(value, out.*f.member);
+        }
+    }
+    template <typename T>
+    static void set_opt(const T&, char, const char*, S&, bool&, bool&) {
+    }
+
+    template <typename T>
+    static void set_pos(
+        const pos_t<S, T>& f,
+        size_t             index,
+        size_t&            base,
+        char*              p,
+        char*&             next,
+        S&                 out,
+        bool&              taken,
+        bool&
+    ) {
+        constexpr size_t n = detail::slots<T>::value;
+        if (!taken && index < base + n) {
+            next = detail::cut_token(p);
+            if constexpr (n == 1) {
+                out.*f.member = p;
+            } else {
+                (out.*f.member)[index - base] = p;
+            }
+            taken = true;
+        }
+        base += n;
+    }
+    static void set_pos(
+        const rest_t<S>& f,
+        size_t,
+        size_t&,
+        char*  p,
+        char*&,
+        S&     out,
+        bool&  taken,
+        bool&  done
+    ) {
+        if (!taken) {
+            out.*f.member = p;
+            taken         = true;
+            done          = true;
+        }
+    }
+    template <typename T>
+    static void set_pos(
+        const T&, size_t, size_t&, char*, char*&, S&, bool&, bool&
+    ) {
+    }
+
+    template <typename W, typename T>
+    static constexpr void usage(W& w, const opt_t<S, T>& f) {
+        w.put(" -");
+        w.put(f.id);
+        if constexpr (!std::is_same_v<T, bool>) {
+            w.put("=X");
+        }
+    }
+    template <typename W, typename P>
+    static constexpr void usage(W& w, const P& f) {
+        w.put(" [");
+        w.put(f.name);
+        w.put(']');
+    }
+
+    template <typename W, typename T>
+    static constexpr void help(W& w, const opt_t<S, T>& f) {
+        w.put("     -");
+        w.put(f.id);
+        w.put(": ");
+        w.put(f.description);
+        w.put('\n');
+    }
+    template <typename W, typename P>
+    static constexpr void help(W& w, const P& f) {
+        // same layout as param_help's "%7s: %s"
+        for (size_t i = detail::length(f.name); i < 7; i++) {
+            w.put(' ');
+        }
+        w.put(f.name);
+        w.put(": ");
+        w.put(f.description);
+        w.put('\n');
+    }
+};
+
+template <typename S, typename... F>
+constexpr schema_t<S, F...> schema(const char* cmd, F... fields) {
+    return {cmd, fields...};
+}
+
+// usage and help text of a schema, rendered at compile time
+template <const auto& Schema>
+inline constexpr auto help = Schema.template text<Schema.text_size()>();
+
+}  // namespace arg
+
 }  // namespace cgx::term